@@ -0,0 +1,245 @@
+/*!
+ * @file BfBytecode.cpp
+ * @brief Compact variable-length bytecode of Brainfuck-IR
+ * @author koturn
+ */
+#include <stack>
+#include <stdexcept>
+#include "BfBytecode.h"
+
+
+namespace bf {
+
+
+/*!
+ * @brief Encode brainfuck IR code into bytecode
+ * @param [in] irCode  Brainfuck IR code
+ */
+void
+BfBytecode::encode(const BfIR &irCode)
+{
+  std::stack<std::size_t> loopStack;
+  code.clear();
+  code.reserve(irCode.size() * 2);
+  for (BfIR::const_iterator cmd = irCode.begin(), end = irCode.end(); cmd != end; cmd++) {
+    code.push_back(static_cast<unsigned char>(cmd->type));
+    switch (cmd->type) {
+      case BfInstruction::LOOP_START:
+      case BfInstruction::IF:
+        loopStack.push(code.size());
+        code.resize(code.size() + sizeof(int32_t));
+        break;
+      case BfInstruction::END_IF:
+        {
+          // IF jumps to just behind END_IF, which has no operand
+          std::size_t bodyPos = loopStack.top() + sizeof(int32_t);
+          loopStack.pop();
+          writeJump(bodyPos - sizeof(int32_t), static_cast<int>(code.size() - bodyPos));
+        }
+        break;
+      case BfInstruction::LOOP_END:
+        {
+          std::size_t bodyPos = loopStack.top() + sizeof(int32_t);
+          std::size_t pos = code.size();
+          loopStack.pop();
+          code.resize(pos + sizeof(int32_t));
+          int offset = static_cast<int>(code.size() - bodyPos);
+          writeJump(bodyPos - sizeof(int32_t), offset);
+          writeJump(pos, -offset);
+        }
+        break;
+      case BfInstruction::NEXT:
+      case BfInstruction::PREV:
+      case BfInstruction::NEXT_N:
+      case BfInstruction::PREV_N:
+      case BfInstruction::INC:
+      case BfInstruction::DEC:
+      case BfInstruction::ADD:
+      case BfInstruction::SUB:
+      case BfInstruction::INC_AT:
+      case BfInstruction::DEC_AT:
+      case BfInstruction::ADD_AT:
+      case BfInstruction::SUB_AT:
+      case BfInstruction::PUTCHAR:
+      case BfInstruction::GETCHAR:
+      case BfInstruction::ASSIGN_ZERO:
+      case BfInstruction::ASSIGN:
+      case BfInstruction::ASSIGN_AT:
+      case BfInstruction::SEARCH_ZERO:
+      case BfInstruction::ADD_VAR:
+      case BfInstruction::SUB_VAR:
+      case BfInstruction::CMUL_VAR:
+      case BfInstruction::MULTI_CMUL_VAR:
+      case BfInstruction::CMUL_TARGET:
+      case BfInstruction::INF_LOOP:
+      case BfInstruction::CHECK:
+      case BfInstruction::PUTS:
+        {
+          int nOperands = getNumberOfOperands(cmd->type);
+          if (nOperands > 0) {
+            writeOperand(cmd->value1);
+          }
+          if (nOperands > 1) {
+            writeOperand(cmd->value2);
+          }
+        }
+        break;
+    }
+  }
+}
+
+
+/*!
+ * @brief Decode bytecode into brainfuck IR code
+ * @return Brainfuck IR code
+ */
+BfIR
+BfBytecode::decode(void) const
+{
+  std::stack<int> loopStack;
+  BfIR irCode;
+  for (const unsigned char *ip = begin(), *last = end(); ip != last;) {
+    BfInstruction::Command cmd;
+    cmd.type = static_cast<BfInstruction::Instruction>(*ip++);
+    cmd.value1 = 0;
+    cmd.value2 = 0;
+    switch (cmd.type) {
+      case BfInstruction::LOOP_START:
+      case BfInstruction::IF:
+        readJump(ip);
+        loopStack.push(static_cast<int>(irCode.size()));
+        break;
+      case BfInstruction::LOOP_END:
+      case BfInstruction::END_IF:
+        if (cmd.type == BfInstruction::LOOP_END) {
+          readJump(ip);
+        }
+        cmd.value1 = loopStack.top();
+        irCode[loopStack.top()].value1 = static_cast<int>(irCode.size());
+        loopStack.pop();
+        break;
+      case BfInstruction::NEXT:
+      case BfInstruction::PREV:
+      case BfInstruction::NEXT_N:
+      case BfInstruction::PREV_N:
+      case BfInstruction::INC:
+      case BfInstruction::DEC:
+      case BfInstruction::ADD:
+      case BfInstruction::SUB:
+      case BfInstruction::INC_AT:
+      case BfInstruction::DEC_AT:
+      case BfInstruction::ADD_AT:
+      case BfInstruction::SUB_AT:
+      case BfInstruction::PUTCHAR:
+      case BfInstruction::GETCHAR:
+      case BfInstruction::ASSIGN_ZERO:
+      case BfInstruction::ASSIGN:
+      case BfInstruction::ASSIGN_AT:
+      case BfInstruction::SEARCH_ZERO:
+      case BfInstruction::ADD_VAR:
+      case BfInstruction::SUB_VAR:
+      case BfInstruction::CMUL_VAR:
+      case BfInstruction::MULTI_CMUL_VAR:
+      case BfInstruction::CMUL_TARGET:
+      case BfInstruction::INF_LOOP:
+      case BfInstruction::CHECK:
+      case BfInstruction::PUTS:
+        {
+          int nOperands = getNumberOfOperands(cmd.type);
+          if (nOperands > 0) {
+            cmd.value1 = readOperand(ip);
+          }
+          if (nOperands > 1) {
+            cmd.value2 = readOperand(ip);
+          }
+        }
+        break;
+    }
+    irCode.push_back(cmd);
+  }
+  return irCode;
+}
+
+
+
+
+/* ========================================================================= *
+ * Private members                                                           *
+ * ========================================================================= */
+/*!
+ * @brief Get the number of varint operands of the instruction
+ * @param [in] type  Type of the instruction
+ * @return The number of varint operands
+ */
+int
+BfBytecode::getNumberOfOperands(BfInstruction::Instruction type)
+{
+  switch (type) {
+    case BfInstruction::NEXT:
+    case BfInstruction::PREV:
+    case BfInstruction::INC:
+    case BfInstruction::DEC:
+    case BfInstruction::LOOP_START:
+    case BfInstruction::LOOP_END:
+    case BfInstruction::IF:
+    case BfInstruction::END_IF:
+    case BfInstruction::ASSIGN_ZERO:
+    case BfInstruction::INF_LOOP:
+      return 0;
+    case BfInstruction::NEXT_N:
+    case BfInstruction::PREV_N:
+    case BfInstruction::ADD:
+    case BfInstruction::SUB:
+    case BfInstruction::INC_AT:
+    case BfInstruction::DEC_AT:
+    case BfInstruction::ASSIGN:
+    case BfInstruction::SEARCH_ZERO:
+    case BfInstruction::PUTCHAR:
+    case BfInstruction::GETCHAR:
+    case BfInstruction::ADD_VAR:
+    case BfInstruction::SUB_VAR:
+    case BfInstruction::MULTI_CMUL_VAR:
+      return 1;
+    case BfInstruction::ADD_AT:
+    case BfInstruction::SUB_AT:
+    case BfInstruction::ASSIGN_AT:
+    case BfInstruction::CMUL_VAR:
+    case BfInstruction::CMUL_TARGET:
+    case BfInstruction::CHECK:
+    case BfInstruction::PUTS:
+      return 2;
+  }
+  throw std::runtime_error("Unknown instruction");
+}
+
+
+/*!
+ * @brief Append a zigzag-encoded varint operand
+ * @param [in] value  Operand
+ */
+void
+BfBytecode::writeOperand(int value)
+{
+  unsigned int u = (static_cast<unsigned int>(value) << 1) ^ static_cast<unsigned int>(value >> 31);
+  while (u >= 0x80) {
+    code.push_back(static_cast<unsigned char>(u | 0x80));
+    u >>= 7;
+  }
+  code.push_back(static_cast<unsigned char>(u));
+}
+
+
+/*!
+ * @brief Write a relative jump offset
+ * @param [in] pos     Position of the operand
+ * @param [in] offset  Jump offset
+ */
+void
+BfBytecode::writeJump(std::size_t pos, int offset)
+{
+  int32_t value = static_cast<int32_t>(offset);
+  std::memcpy(&code[pos], &value, sizeof(value));
+}
+
+
+}  // namespace bf
@@ -0,0 +1,96 @@
+/*!
+ * @file BfBytecode.h
+ * @brief Compact variable-length bytecode of Brainfuck-IR
+ * @author koturn
+ */
+#ifndef BF_BYTECODE_H
+#define BF_BYTECODE_H
+
+#include <cstring>
+#include <vector>
+#if __cplusplus >= 201103L
+#  include <cstdint>
+#else
+#  include <stdint.h>
+#endif  // __cplusplus >= 201103L
+#include "BfIRCompiler.h"
+#include "compat.h"
+
+
+namespace bf {
+
+
+/*!
+ * @brief Compact variable-length bytecode of Brainfuck-IR
+ *
+ * Each instruction is encoded as one byte of BfInstruction::Instruction,
+ * followed by its operands.
+ * Operands of LOOP_START, LOOP_END and IF are 32-bit relative jump offsets
+ * in native byte order, and END_IF has no operand; the other operands are
+ * zigzag-encoded varints, so that most instructions fit in one or two bytes.
+ * Bytecode can be decoded into the original Brainfuck-IR without loss.
+ */
+class BfBytecode {
+public:
+  BfBytecode(void) :
+    code()
+  {}
+
+  void encode(const BfIR &irCode);
+  BfIR decode(void) const;
+  inline const unsigned char *begin(void) const { return code.empty() ? nullptr : &code[0]; }
+  inline const unsigned char *end(void) const { return begin() + code.size(); }
+  inline std::size_t getSize(void) const { return code.size(); }
+
+  static inline int readOperand(const unsigned char *&ip);
+  static inline int readJump(const unsigned char *&ip);
+
+private:
+  std::vector<unsigned char> code;
+
+  static int getNumberOfOperands(BfInstruction::Instruction type);
+  void writeOperand(int value);
+  void writeJump(std::size_t pos, int offset);
+};
+
+
+/*!
+ * @brief Read a zigzag-encoded varint operand and advance ip
+ * @param [in,out] ip  Instruction pointer which points to the operand
+ * @return Decoded operand
+ */
+inline int
+BfBytecode::readOperand(const unsigned char *&ip)
+{
+  unsigned int value = *ip++;
+  if (value >= 0x80) {
+    unsigned int b;
+    int shift = 7;
+    value &= 0x7f;
+    do {
+      b = *ip++;
+      value |= (b & 0x7f) << shift;
+      shift += 7;
+    } while (b >= 0x80);
+  }
+  return static_cast<int>(value >> 1) ^ -static_cast<int>(value & 1);
+}
+
+
+/*!
+ * @brief Read a relative jump offset and advance ip
+ * @param [in,out] ip  Instruction pointer which points to the operand
+ * @return Jump offset, which is relative to the next instruction
+ */
+inline int
+BfBytecode::readJump(const unsigned char *&ip)
+{
+  int32_t offset;
+  std::memcpy(&offset, ip, sizeof(offset));
+  ip += sizeof(offset);
+  return offset;
+}
+
+
+}  // namespace bf
+#endif  // BF_BYTECODE_H
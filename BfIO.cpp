@@ -0,0 +1,208 @@
+/*!
+ * @file BfIO.cpp
+ * @brief Buffered I/O layer for Brainfuck engines
+ * @author koturn
+ */
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#if defined(_MSC_VER)
+#  include <io.h>
+#else
+#  include <unistd.h>
+#endif  // defined(_MSC_VER)
+#include "BfIO.h"
+
+#if defined(_MSC_VER)
+#  define BF_READ(fd, buf, size)   ::_read(fd, buf, static_cast<unsigned int>(size))
+#  define BF_WRITE(fd, buf, size)  ::_write(fd, buf, static_cast<unsigned int>(size))
+#  define BF_ISATTY(fd)            ::_isatty(fd)
+#else
+#  define BF_READ(fd, buf, size)   ::read(fd, buf, size)
+#  define BF_WRITE(fd, buf, size)  ::write(fd, buf, size)
+#  define BF_ISATTY(fd)            ::isatty(fd)
+#endif  // defined(_MSC_VER)
+
+
+namespace bf {
+
+
+/*!
+ * @brief Write the byte sequence
+ * @param [in] data  Pointer to the byte sequence
+ * @param [in] size  Size of the byte sequence
+ */
+void
+BfIO::write(const void *data, std::size_t size)
+{
+  const char *bytes = static_cast<const char *>(data);
+  if (size > outBuffer.size() - outPos) {
+    flush();
+    if (size >= outBuffer.size()) {
+      // Don't copy the large block into the buffer
+      writeBlock(bytes, size);
+      return;
+    }
+  }
+  std::memcpy(&outBuffer[outPos], bytes, size);
+  outPos += size;
+  if ((flushPolicy & FLUSH_ON_NEWLINE) != 0 && std::memchr(bytes, '\n', size) != nullptr) {
+    flush();
+  }
+}
+
+
+/*!
+ * @brief Pass the buffered output to the backend
+ */
+void
+BfIO::flush(void)
+{
+  if (outPos != 0) {
+    writeBlock(&outBuffer[0], outPos);
+    outPos = 0;
+  }
+}
+
+
+/*!
+ * @brief Pass the buffered output to the backend from the fault handler
+ *
+ * This function is async-signal-safe if writeBlockOnFault() is, so that the
+ * output is not lost when the process exits on the tape overflow.
+ */
+void
+BfIO::flushOnFault(void)
+{
+  if (outPos != 0) {
+    writeBlockOnFault(&outBuffer[0], outPos);
+    outPos = 0;
+  }
+}
+
+
+/*!
+ * @brief Write the byte sequence to the backend from the fault handler
+ *
+ * The buffered output is written before the byte sequence, which is not
+ * buffered.
+ * @param [in] data  Pointer to the byte sequence
+ * @param [in] size  Size of the byte sequence
+ */
+void
+BfIO::writeOnFault(const void *data, std::size_t size)
+{
+  flushOnFault();
+  writeBlockOnFault(static_cast<const char *>(data), size);
+}
+
+
+/*!
+ * @brief Refill the input buffer
+ * @return false on EOF, otherwise true
+ */
+bool
+BfIO::fill(void)
+{
+  if ((flushPolicy & FLUSH_ON_INPUT) != 0) {
+    flush();
+  }
+  inPos = 0;
+  inSize = readBlock(&inBuffer[0], inBuffer.size());
+  return inSize != 0;
+}
+
+
+
+
+/*!
+ * @brief Constructor
+ * @param [in] inFd        File descriptor of the input
+ * @param [in] outFd       File descriptor of the output
+ * @param [in] bufferSize  Size of the input and output buffer
+ */
+BfFdIO::BfFdIO(int inFd, int outFd, std::size_t bufferSize) :
+  BfIO(bufferSize, BF_ISATTY(outFd) ? FLUSH_ON_INPUT | FLUSH_ON_NEWLINE : FLUSH_ON_INPUT),
+  inFd(inFd),
+  outFd(outFd)
+{}
+
+
+BfFdIO::~BfFdIO(void)
+{
+  flush();
+}
+
+
+std::size_t
+BfFdIO::readBlock(char *buf, std::size_t size)
+{
+  for (;;) {
+    long n = static_cast<long>(BF_READ(inFd, buf, size));
+    if (n >= 0) {
+      return static_cast<std::size_t>(n);
+    } else if (errno != EINTR) {
+      return 0;
+    }
+  }
+}
+
+
+void
+BfFdIO::writeBlock(const char *buf, std::size_t size)
+{
+  while (size > 0) {
+    long n = static_cast<long>(BF_WRITE(outFd, buf, size));
+    if (n > 0) {
+      buf += n;
+      size -= static_cast<std::size_t>(n);
+    } else if (n < 0 && errno == EINTR) {
+      continue;
+    } else {
+      // Discard the output on error, as stdio does
+      return;
+    }
+  }
+}
+
+
+/*!
+ * @brief Write all bytes to the file descriptor from the fault handler
+ *
+ * writeBlock() only calls write(2), which is async-signal-safe.
+ * @param [in] buf   Source buffer
+ * @param [in] size  The number of bytes to write
+ */
+void
+BfFdIO::writeBlockOnFault(const char *buf, std::size_t size)
+{
+  writeBlock(buf, size);
+}
+
+
+
+
+BfMemoryIO::~BfMemoryIO(void)
+{
+  flush();
+}
+
+
+std::size_t
+BfMemoryIO::readBlock(char *buf, std::size_t size)
+{
+  std::size_t n = std::min(size, input.size() - inputPos);
+  input.copy(buf, n, inputPos);
+  inputPos += n;
+  return n;
+}
+
+
+void
+BfMemoryIO::writeBlock(const char *buf, std::size_t size)
+{
+  output.append(buf, size);
+}
+
+
+}  // namespace bf
@@ -0,0 +1,179 @@
+/*!
+ * @file BfIO.h
+ * @brief Buffered I/O layer for Brainfuck engines
+ * @author koturn
+ */
+#ifndef BF_IO_H
+#define BF_IO_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "compat.h"
+
+
+namespace bf {
+
+
+/*!
+ * @brief Buffered I/O layer for Brainfuck engines
+ *
+ * Output is accumulated in the user-space buffer and passed to the backend
+ * when the buffer is full, when flush() is called, and at the timing which
+ * is specified by the flush policy.
+ * Input is read from the backend block by block.
+ * Subclasses implement the backend with readBlock() and writeBlock().
+ */
+class BfIO {
+public:
+  /*!
+   * @brief Flush policy, which can be combined with bitwise OR
+   *
+   * The output buffer is always flushed when it is full and when flush() is
+   * called at exit.
+   */
+  typedef enum {
+    FLUSH_ON_SIZE    = 0x00,  //!< Flush only when the buffer is full
+    FLUSH_ON_INPUT   = 0x01,  //!< Flush before waiting for input
+    FLUSH_ON_NEWLINE = 0x02   //!< Flush after each newline
+  } FlushPolicy;
+
+  static const std::size_t DEFAULT_BUFFER_SIZE = 65536;
+  static const int END_OF_FILE = -1;
+
+  BfIO(std::size_t bufferSize=DEFAULT_BUFFER_SIZE, int flushPolicy=FLUSH_ON_INPUT) :
+    outBuffer(bufferSize),
+    outPos(0),
+    inBuffer(bufferSize),
+    inPos(0),
+    inSize(0),
+    flushPolicy(flushPolicy)
+  {}
+  virtual ~BfIO(void) {}
+
+  inline void put(int ch);
+  inline int get(void);
+  void write(const void *data, std::size_t size);
+  void flush(void);
+  void flushOnFault(void);
+  void writeOnFault(const void *data, std::size_t size);
+  void setFlushPolicy(int flushPolicy) { this->flushPolicy = flushPolicy; }
+  int getFlushPolicy(void) const { return flushPolicy; }
+
+protected:
+  /*!
+   * @brief Read at most size bytes from the backend
+   * @param [out] buf   Destination buffer
+   * @param [in]  size  Size of the destination buffer
+   * @return The number of bytes read, or 0 on EOF
+   */
+  virtual std::size_t readBlock(char *buf, std::size_t size) = 0;
+  /*!
+   * @brief Write all bytes to the backend
+   * @param [in] buf   Source buffer
+   * @param [in] size  The number of bytes to write
+   */
+  virtual void writeBlock(const char *buf, std::size_t size) = 0;
+  /*!
+   * @brief Write all bytes to the backend from the fault handler
+   *
+   * This function must be async-signal-safe; the default implementation
+   * discards the bytes.
+   * @param [in] buf   Source buffer
+   * @param [in] size  The number of bytes to write
+   */
+  virtual void writeBlockOnFault(const char * /* buf */, std::size_t /* size */) {}
+
+private:
+  std::vector<char> outBuffer;
+  std::size_t outPos;
+  std::vector<char> inBuffer;
+  std::size_t inPos;
+  std::size_t inSize;
+  int flushPolicy;
+
+  bool fill(void);
+};
+
+
+/*!
+ * @brief I/O backed by file descriptors
+ *
+ * If the output is a terminal, the output is also flushed on each newline.
+ */
+class BfFdIO : public BfIO {
+public:
+  BfFdIO(int inFd=0, int outFd=1, std::size_t bufferSize=DEFAULT_BUFFER_SIZE);
+  ~BfFdIO(void);
+
+protected:
+  std::size_t readBlock(char *buf, std::size_t size);
+  void writeBlock(const char *buf, std::size_t size);
+  void writeBlockOnFault(const char *buf, std::size_t size);
+
+private:
+  int inFd;
+  int outFd;
+};
+
+
+/*!
+ * @brief I/O backed by in-memory buffers
+ */
+class BfMemoryIO : public BfIO {
+public:
+  BfMemoryIO(const std::string &input=std::string(), std::size_t bufferSize=DEFAULT_BUFFER_SIZE) :
+    BfIO(bufferSize, FLUSH_ON_SIZE),
+    input(input),
+    inputPos(0),
+    output()
+  {}
+  ~BfMemoryIO(void);
+
+  /*!
+   * @brief Get the output which has been written so far
+   * @return Output string
+   */
+  const std::string &getOutput(void) { flush(); return output; }
+
+protected:
+  std::size_t readBlock(char *buf, std::size_t size);
+  void writeBlock(const char *buf, std::size_t size);
+
+private:
+  std::string input;
+  std::size_t inputPos;
+  std::string output;
+};
+
+
+/*!
+ * @brief Write one byte
+ * @param [in] ch  Byte to write
+ */
+inline void
+BfIO::put(int ch)
+{
+  outBuffer[outPos++] = static_cast<char>(ch);
+  if (outPos == outBuffer.size() || (ch == '\n' && (flushPolicy & FLUSH_ON_NEWLINE) != 0)) {
+    flush();
+  }
+}
+
+
+/*!
+ * @brief Read one byte
+ * @return Byte which is read, or END_OF_FILE
+ */
+inline int
+BfIO::get(void)
+{
+  if (inPos == inSize && !fill()) {
+    return END_OF_FILE;
+  }
+  return static_cast<unsigned char>(inBuffer[inPos++]);
+}
+
+
+}  // namespace bf
+#endif  // BF_IO_H
@@ -3,14 +3,18 @@
  * @brief Brainfuck-IR compiler
  * @author koturn
  */
+#include <cstring>
+#include <map>
 #include <stack>
 #include <queue>
+#include <stdexcept>
 #include "BfIRCompiler.h"
+#include "BfIROptimizer.h"
+#include "BfSimd.h"
 
 
-template<char INST1, char INST2>
-static int
-compressInstruction(const char **_srcptr);
+inline static char
+getReverseCommand(char command);
 
 inline static bool
 genOperationAt(bf::BfInstruction::Command &cmd, const bf::BfInstruction::Command &c1);
@@ -18,8 +22,14 @@ genOperationAt(bf::BfInstruction::Command &cmd, const bf::BfInstruction::Command
 inline static bool
 isPtrOperation(bf::BfInstruction::Instruction inst);
 
-inline static bool
-isOperationAt(bf::BfInstruction::Instruction inst);
+static bool
+analyzeMultiplyLoop(const bf::BfIR &irCode, bf::BfIR::size_type pos, std::map<int, int> &deltaMap);
+
+static void
+genMultiplyLoop(bf::BfIR &irCode, const std::map<int, int> &deltaMap);
+
+static bool
+exceedsOffset(const bf::BfIR &irCode, int limit);
 
 
 
@@ -33,287 +43,395 @@ namespace bf {
 void
 BfIRCompiler::compile(void)
 {
-  std::stack<unsigned int> loopStack;
+  reset();
+  feed(bfSource, std::strlen(bfSource));
+  finish();
+}
+
+
+/*!
+ * @brief Start the streaming compilation
+ *
+ * Source code is given with feed() chunk by chunk, and the compilation is
+ * completed with finish().
+ */
+void
+BfIRCompiler::reset(void)
+{
   irCode.clear();
-  for (const char *srcptr = bfSource; *srcptr != '\0'; srcptr++) {
-    BfInstruction::Command cmd;
-    switch (*srcptr) {
-      case '>':
-        {
-          bool isNormalNext = true;
-          srcptr++;
-          int value = compressInstruction<'>', '<'>(&srcptr) + 1;
-          if (irCode.size() > 1) {
-            BfInstruction::Command c1 = irCode[irCode.size() - 1];  // (+*|-*) ?
-            BfInstruction::Command c2 = irCode[irCode.size() - 2];  // <* ?
-            if (value == 1 && c2.type == BfInstruction::PREV) {
-              cmd.value1 = -1;
-              isNormalNext = genOperationAt(cmd, c1);
-            } else if (value == -1 && c2.type == BfInstruction::NEXT) {
-              cmd.value1 = 1;
-              isNormalNext = genOperationAt(cmd, c1);
-            } else if (value > 1 && c2.type == BfInstruction::PREV_N && value == c2.value1) {
-              cmd.value1 = -c2.value1;
-              isNormalNext = genOperationAt(cmd, c1);
-            } else if (value < 1 && c2.type == BfInstruction::NEXT_N && -value == c2.value1) {
-              cmd.value1 = c2.value1;
-              isNormalNext = genOperationAt(cmd, c1);
-            }
+  strings.clear();
+  std::stack<unsigned int>().swap(loopStack);
+  runCommand = '\0';
+  runValue = 0;
+}
+
+
+/*!
+ * @brief Compile the next chunk of source code
+ *
+ * Non-Brainfuck characters are skipped, and continuous '+'/'-' and '>'/'<'
+ * are merged into one token, even if they are across the chunks.
+ * @param [in] data  Chunk of source code, which needn't be NUL-terminated
+ * @param [in] size  Size of the chunk
+ */
+void
+BfIRCompiler::feed(const char *data, std::size_t size)
+{
+  char chunk[FEED_CHUNK_SIZE];
+  while (size > 0) {
+    std::size_t n = size < FEED_CHUNK_SIZE ? size : FEED_CHUNK_SIZE;
+    std::size_t nCommands = BfSimd::compactCommands(chunk, data, n);
+    for (const char *srcptr = chunk; srcptr != chunk + nCommands; srcptr++) {
+      if (*srcptr == runCommand) {
+        runValue++;
+      } else if (*srcptr == getReverseCommand(runCommand)) {
+        runValue--;
+      } else {
+        flushRun();
+        if (getReverseCommand(*srcptr) != '\0') {
+          runCommand = *srcptr;
+          runValue = 1;
+        } else {
+          emit(*srcptr, 0);
+        }
+      }
+    }
+    data += n;
+    size -= n;
+  }
+}
+
+
+/*!
+ * @brief Complete the streaming compilation
+ *
+ * Unmatched brackets are reported as the parse error.
+ * If the offset limit is enabled, code whose pointer movement or offset
+ * exceeds MAX_OFFSET is rejected, so that any access out of the tape hits
+ * the guard regions of BfTape.
+ */
+void
+BfIRCompiler::finish(void)
+{
+  flushRun();
+  if (!loopStack.empty()) {
+    throw std::runtime_error("Parse error: cannot find the end of loop");
+  }
+  BfIROptimizer::sinkPointerMotion(irCode);
+  if (prefixEvaluation && memorySize != 0) {
+    BfIROptimizer::evaluatePrefix(irCode, memorySize);
+  }
+  BfIROptimizer::propagateKnownValues(irCode, memorySize);
+  BfIROptimizer::coalesceOutput(irCode, strings);
+  if (offsetLimit && exceedsOffset(irCode, MAX_OFFSET)) {
+    throw std::runtime_error("Compile error: too long pointer movement");
+  }
+  if (boundsCheck) {
+    BfIROptimizer::insertBoundsChecks(irCode);
+  }
+  irModule = BfIRModule(irCode, strings);
+}
+
+
+/*!
+ * @brief Emit the pending run of '+'/'-' or '>'/'<'
+ */
+void
+BfIRCompiler::flushRun(void)
+{
+  if (runCommand != '\0') {
+    emit(runCommand, runValue);
+    runCommand = '\0';
+    runValue = 0;
+  }
+}
+
+
+/*!
+ * @brief Append the instruction for one token
+ * @param [in] command  Brainfuck-character
+ * @param [in] value    Compressed value of the run which starts with command;
+ *                      ignored for '.', ',', '[' and ']'
+ */
+void
+BfIRCompiler::emit(char command, int value)
+{
+  BfInstruction::Command cmd;
+  switch (command) {
+    case '>':
+      {
+        bool isNormalNext = true;
+        if (irCode.size() > 1) {
+          BfInstruction::Command c1 = irCode[irCode.size() - 1];  // (+*|-*) ?
+          BfInstruction::Command c2 = irCode[irCode.size() - 2];  // <* ?
+          if (value == 1 && c2.type == BfInstruction::PREV) {
+            cmd.value1 = -1;
+            isNormalNext = genOperationAt(cmd, c1);
+          } else if (value == -1 && c2.type == BfInstruction::NEXT) {
+            cmd.value1 = 1;
+            isNormalNext = genOperationAt(cmd, c1);
+          } else if (value > 1 && c2.type == BfInstruction::PREV_N && value == c2.value1) {
+            cmd.value1 = -c2.value1;
+            isNormalNext = genOperationAt(cmd, c1);
+          } else if (value < 1 && c2.type == BfInstruction::NEXT_N && -value == c2.value1) {
+            cmd.value1 = c2.value1;
+            isNormalNext = genOperationAt(cmd, c1);
           }
-          if (isNormalNext) {
-            if (value > 0) {
-              if (value == 1) {
-                cmd.type = BfInstruction::NEXT;
-                cmd.value1 = 0;
-                cmd.value2 = 0;
-              } else {
-                cmd.type = BfInstruction::NEXT_N;
-                cmd.value1 = value;
-                cmd.value2 = 0;
-              }
-            } else if (value < 0) {
-              if (value == -1) {
-                cmd.type = BfInstruction::PREV;
-                cmd.value1 = 0;
-                cmd.value2 = 0;
-              } else {
-                cmd.type = BfInstruction::PREV_N;
-                cmd.value1 = -value;
-                cmd.value2 = 0;
-              }
+        }
+        if (isNormalNext) {
+          if (value > 0) {
+            if (value == 1) {
+              cmd.type = BfInstruction::NEXT;
+              cmd.value1 = 0;
+              cmd.value2 = 0;
+            } else {
+              cmd.type = BfInstruction::NEXT_N;
+              cmd.value1 = value;
+              cmd.value2 = 0;
+            }
+          } else if (value < 0) {
+            if (value == -1) {
+              cmd.type = BfInstruction::PREV;
+              cmd.value1 = 0;
+              cmd.value2 = 0;
             } else {
-              continue;
+              cmd.type = BfInstruction::PREV_N;
+              cmd.value1 = -value;
+              cmd.value2 = 0;
             }
           } else {
-            irCode.pop_back(); irCode.pop_back();
+            return;
           }
+        } else {
+          irCode.pop_back(); irCode.pop_back();
         }
-        break;
-      case '<':
-        {
-          bool isNormalPrev = true;
-          srcptr++;
-          int value = compressInstruction<'<', '>'>(&srcptr) + 1;
-          if (irCode.size() > 1) {
-            BfInstruction::Command c1 = irCode[irCode.size() - 1];  // (+*|-*) ?
-            BfInstruction::Command c2 = irCode[irCode.size() - 2];  // >* ?
-            if (value == 1 && c2.type == BfInstruction::NEXT) {
-              cmd.value1 = 1;
-              isNormalPrev = genOperationAt(cmd, c1);
-            } else if (value == -1 && c2.type == BfInstruction::PREV) {
-              cmd.value1 = -1;
-              isNormalPrev = genOperationAt(cmd, c1);
-            } else if (value > 0 && c2.type == BfInstruction::NEXT_N && value == c2.value1) {
-              cmd.value1 = c2.value1;
-              isNormalPrev = genOperationAt(cmd, c1);
-            } else if (value < 0 && c2.type == BfInstruction::PREV_N && -value == c2.value1) {
-              cmd.value1 = -c2.value1;
-              isNormalPrev = genOperationAt(cmd, c1);
-            }
+      }
+      break;
+    case '<':
+      {
+        bool isNormalPrev = true;
+        if (irCode.size() > 1) {
+          BfInstruction::Command c1 = irCode[irCode.size() - 1];  // (+*|-*) ?
+          BfInstruction::Command c2 = irCode[irCode.size() - 2];  // >* ?
+          if (value == 1 && c2.type == BfInstruction::NEXT) {
+            cmd.value1 = 1;
+            isNormalPrev = genOperationAt(cmd, c1);
+          } else if (value == -1 && c2.type == BfInstruction::PREV) {
+            cmd.value1 = -1;
+            isNormalPrev = genOperationAt(cmd, c1);
+          } else if (value > 0 && c2.type == BfInstruction::NEXT_N && value == c2.value1) {
+            cmd.value1 = c2.value1;
+            isNormalPrev = genOperationAt(cmd, c1);
+          } else if (value < 0 && c2.type == BfInstruction::PREV_N && -value == c2.value1) {
+            cmd.value1 = -c2.value1;
+            isNormalPrev = genOperationAt(cmd, c1);
           }
-          if (isNormalPrev) {
-            if (value > 0) {
-              if (value == 1) {
-                cmd.type = BfInstruction::PREV;
-                cmd.value1 = 0;
-                cmd.value2 = 0;
-              } else {
-                cmd.type = BfInstruction::PREV_N;
-                cmd.value1 = value;
-                cmd.value2 = 0;
-              }
-            } else if (value < 0) {
-              if (value == 1) {
-                cmd.type = BfInstruction::NEXT;
-                cmd.value1 = 0;
-                cmd.value2 = 0;
-              } else {
-                cmd.type = BfInstruction::NEXT_N;
-                cmd.value1 = -value;
-                cmd.value2 = 0;
-              }
+        }
+        if (isNormalPrev) {
+          if (value > 0) {
+            if (value == 1) {
+              cmd.type = BfInstruction::PREV;
+              cmd.value1 = 0;
+              cmd.value2 = 0;
+            } else {
+              cmd.type = BfInstruction::PREV_N;
+              cmd.value1 = value;
+              cmd.value2 = 0;
+            }
+          } else if (value < 0) {
+            if (value == 1) {
+              cmd.type = BfInstruction::NEXT;
+              cmd.value1 = 0;
+              cmd.value2 = 0;
             } else {
-              continue;
+              cmd.type = BfInstruction::NEXT_N;
+              cmd.value1 = -value;
+              cmd.value2 = 0;
             }
           } else {
-            irCode.pop_back(); irCode.pop_back();
+            return;
           }
+        } else {
+          irCode.pop_back(); irCode.pop_back();
         }
-        break;
-      case '+':
-        {
-          srcptr++;
-          int value = compressInstruction<'+', '-'>(&srcptr) + 1;
-          if (irCode.size() > 0 && irCode[irCode.size() - 1].type == BfInstruction::ASSIGN_ZERO) {
-            cmd.type = BfInstruction::ASSIGN;
-            cmd.value1 = value;
-            cmd.value2 = 0;
-            irCode.pop_back();
-          } else {
-            if (value > 0) {
-              if (value == 1) {
-                cmd.type = BfInstruction::INC;
-                cmd.value1 = 0;
-                cmd.value2 = 0;
-              } else {
-                cmd.type = BfInstruction::ADD;
-                cmd.value1 = value;
-                cmd.value2 = 0;
-              }
-            } else if (value < 0) {
-              if (value == 1) {
-                cmd.type = BfInstruction::DEC;
-                cmd.value1 = 0;
-                cmd.value2 = 0;
-              } else {
-                cmd.type = BfInstruction::SUB;
-                cmd.value1 = -value;
-                cmd.value2 = 0;
-              }
+      }
+      break;
+    case '+':
+      {
+        // Negative values are left to SUB, which wraps in any width of the
+        // cell
+        if (value > 0 && irCode.size() > 0 && irCode[irCode.size() - 1].type == BfInstruction::ASSIGN_ZERO) {
+          cmd.type = BfInstruction::ASSIGN;
+          cmd.value1 = value;
+          cmd.value2 = 0;
+          irCode.pop_back();
+        } else {
+          if (value > 0) {
+            if (value == 1) {
+              cmd.type = BfInstruction::INC;
+              cmd.value1 = 0;
+              cmd.value2 = 0;
+            } else {
+              cmd.type = BfInstruction::ADD;
+              cmd.value1 = value;
+              cmd.value2 = 0;
+            }
+          } else if (value < 0) {
+            if (value == 1) {
+              cmd.type = BfInstruction::DEC;
+              cmd.value1 = 0;
+              cmd.value2 = 0;
             } else {
-              continue;
+              cmd.type = BfInstruction::SUB;
+              cmd.value1 = -value;
+              cmd.value2 = 0;
             }
+          } else {
+            return;
           }
         }
-        break;
-      case '-':
-        {
-          srcptr++;
-          int value = compressInstruction<'-', '+'>(&srcptr) + 1;
-          if (irCode.size() > 0 && irCode[irCode.size() - 1].type == BfInstruction::ASSIGN_ZERO) {
-            cmd.type = BfInstruction::ASSIGN;
-            while (value < 0) {
-              value += 256;
+      }
+      break;
+    case '-':
+      {
+        if (value < 0 && irCode.size() > 0 && irCode[irCode.size() - 1].type == BfInstruction::ASSIGN_ZERO) {
+          cmd.type = BfInstruction::ASSIGN;
+          cmd.value1 = -value;
+          cmd.value2 = 0;
+          irCode.pop_back();
+        } else {
+          if (value > 0) {
+            if (value == 1) {
+              cmd.type = BfInstruction::DEC;
+              cmd.value1 = 0;
+              cmd.value2 = 0;
+            } else {
+              cmd.type = BfInstruction::SUB;
+              cmd.value1 = value;
+              cmd.value2 = 0;
             }
-            cmd.value1 = value;
-            cmd.value2 = 0;
-            irCode.pop_back();
-          } else {
-            if (value > 0) {
-              if (value == 1) {
-                cmd.type = BfInstruction::DEC;
-                cmd.value1 = 0;
-                cmd.value2 = 0;
-              } else {
-                cmd.type = BfInstruction::SUB;
-                cmd.value1 = value;
-                cmd.value2 = 0;
-              }
-            } else if (value < 0) {
-              if (value == 1) {
-                cmd.type = BfInstruction::INC;
-                cmd.value1 = 0;
-                cmd.value2 = 0;
-              } else {
-                cmd.type = BfInstruction::ADD;
-                cmd.value1 = -value;
-                cmd.value2 = 0;
-              }
+          } else if (value < 0) {
+            if (value == 1) {
+              cmd.type = BfInstruction::INC;
+              cmd.value1 = 0;
+              cmd.value2 = 0;
             } else {
-              continue;
+              cmd.type = BfInstruction::ADD;
+              cmd.value1 = -value;
+              cmd.value2 = 0;
             }
+          } else {
+            return;
           }
         }
-        break;
-      case '.':
-        cmd.type = BfInstruction::PUTCHAR;
-        cmd.value1 = 0;
-        cmd.value2 = 0;
-        break;
-      case ',':
-        cmd.type = BfInstruction::GETCHAR;
-        cmd.value1 = 0;
-        cmd.value2 = 0;
-        break;
-      case '[':
-        cmd.type = BfInstruction::LOOP_START;
-        loopStack.push(static_cast<unsigned int>(irCode.size()));
-        break;
-      case ']':
-        {
-          bool isNormalLoopEnd = true;
-          BfIR::size_type size = irCode.size();
-          if (size > 0 && irCode[size - 1].type == BfInstruction::LOOP_START) {
-            cmd.type = BfInstruction::INF_LOOP;
+      }
+      break;
+    case '.':
+      cmd.type = BfInstruction::PUTCHAR;
+      cmd.value1 = 0;
+      cmd.value2 = 0;
+      break;
+    case ',':
+      cmd.type = BfInstruction::GETCHAR;
+      cmd.value1 = 0;
+      cmd.value2 = 0;
+      break;
+    case '[':
+      cmd.type = BfInstruction::LOOP_START;
+      cmd.value1 = 0;
+      cmd.value2 = 0;
+      loopStack.push(static_cast<unsigned int>(irCode.size()));
+      break;
+    case ']':
+      {
+        if (loopStack.empty()) {
+          throw std::runtime_error("Parse error: cannot find the start of loop");
+        }
+        bool isNormalLoopEnd = true;
+        BfIR::size_type size = irCode.size();
+        if (size > 0 && irCode[size - 1].type == BfInstruction::LOOP_START) {
+          cmd.type = BfInstruction::INF_LOOP;
+          cmd.value1 = 0;
+          cmd.value2 = 0;
+          irCode.pop_back();
+          isNormalLoopEnd = false;
+        }
+        if (size > 1 && irCode[size - 2].type == BfInstruction::LOOP_START) {
+          BfInstruction::Command &c1 = irCode[size - 1];
+          if (c1.type == BfInstruction::INC || c1.type == BfInstruction::DEC) {
+            cmd.type = BfInstruction::ASSIGN_ZERO;
             cmd.value1 = 0;
             cmd.value2 = 0;
-            irCode.pop_back();
+            irCode.pop_back(); irCode.pop_back();
             isNormalLoopEnd = false;
-          }
-          if (size > 1 && irCode[size - 2].type == BfInstruction::LOOP_START) {
-            BfInstruction::Command &c1 = irCode[size - 1];
-            if (c1.type == BfInstruction::INC || c1.type == BfInstruction::DEC) {
-              cmd.type = BfInstruction::ASSIGN_ZERO;
-              cmd.value1 = 0;
-              cmd.value2 = 0;
-              irCode.pop_back(); irCode.pop_back();
-              isNormalLoopEnd = false;
-            } else if (isPtrOperation(c1.type)) {
-              cmd.type = BfInstruction::SEARCH_ZERO;
-              switch (c1.type) {
-                case BfInstruction::NEXT:
-                  cmd.value1 = 1;
-                  break;
-                case BfInstruction::PREV:
-                  cmd.value1 = -1;
-                  break;
-                case BfInstruction::NEXT_N:
-                  cmd.value1 = c1.value1;
-                  break;
-                case BfInstruction::PREV_N:
-                  cmd.value1 = -c1.value1;
-                  break;
-              }
-              cmd.value2 = 0;
-              irCode.pop_back(); irCode.pop_back();
-              isNormalLoopEnd = false;
+          } else if (isPtrOperation(c1.type)) {
+            cmd.type = BfInstruction::SEARCH_ZERO;
+            switch (c1.type) {
+              case BfInstruction::NEXT:
+                cmd.value1 = 1;
+                break;
+              case BfInstruction::PREV:
+                cmd.value1 = -1;
+                break;
+              case BfInstruction::NEXT_N:
+                cmd.value1 = c1.value1;
+                break;
+              case BfInstruction::PREV_N:
+                cmd.value1 = -c1.value1;
+                break;
+              case BfInstruction::INC:
+              case BfInstruction::DEC:
+              case BfInstruction::ADD:
+              case BfInstruction::SUB:
+              case BfInstruction::INC_AT:
+              case BfInstruction::DEC_AT:
+              case BfInstruction::ADD_AT:
+              case BfInstruction::SUB_AT:
+              case BfInstruction::PUTCHAR:
+              case BfInstruction::GETCHAR:
+              case BfInstruction::LOOP_START:
+              case BfInstruction::LOOP_END:
+              case BfInstruction::ASSIGN_ZERO:
+              case BfInstruction::ASSIGN:
+              case BfInstruction::ASSIGN_AT:
+              case BfInstruction::SEARCH_ZERO:
+              case BfInstruction::ADD_VAR:
+              case BfInstruction::SUB_VAR:
+              case BfInstruction::CMUL_VAR:
+              case BfInstruction::MULTI_CMUL_VAR:
+              case BfInstruction::CMUL_TARGET:
+              case BfInstruction::INF_LOOP:
+              case BfInstruction::CHECK:
+              case BfInstruction::PUTS:
+              case BfInstruction::IF:
+              case BfInstruction::END_IF:
+                break;
             }
-          }
-          if (size > 2) {  // [->+<]
-            BfInstruction::Command &c1 = irCode[size - 1];  // >*(+|-)*<* ? or - ?
-            BfInstruction::Command &c2 = irCode[size - 2];  // - ? or >*(+|-)*<* ?
-            BfInstruction::Command &c3 = irCode[size - 3];  // [ ?
-            if (c3.type == BfInstruction::LOOP_START &&
-                ((c2.type == BfInstruction::DEC && isOperationAt(c1.type)) ||
-                 (isOperationAt(c2.type) && c1.type == BfInstruction::DEC))) {
-              BfInstruction::Command &c = (c2.type == BfInstruction::DEC) ? c1 : c2;
-              switch (c.type) {
-                case BfInstruction::INC_AT:
-                  cmd.type = BfInstruction::ADD_VAR;
-                  cmd.value1 = c.value1;
-                  cmd.value2 = 0;
-                  irCode.pop_back(); irCode.pop_back(); irCode.pop_back();
-                  isNormalLoopEnd = false;
-                  break;
-                case BfInstruction::DEC_AT:
-                  cmd.type = BfInstruction::SUB_VAR;
-                  cmd.value1 = c.value1;
-                  cmd.value2 = 0;
-                  irCode.pop_back(); irCode.pop_back(); irCode.pop_back();
-                  isNormalLoopEnd = false;
-                  break;
-                case BfInstruction::ADD_AT:
-                  cmd.type = BfInstruction::CMUL_VAR;
-                  cmd.value1 = c.value1;
-                  cmd.value2 = c.value2;
-                  irCode.pop_back(); irCode.pop_back(); irCode.pop_back();
-                  isNormalLoopEnd = false;
-                  break;
-              }
-            }
-          }
-          if (isNormalLoopEnd) {
-            cmd.type = BfInstruction::LOOP_END;
-            cmd.value1 = loopStack.top();
             cmd.value2 = 0;
-            irCode[loopStack.top()].value1 = static_cast<int>(irCode.size());
+            irCode.pop_back(); irCode.pop_back();
+            isNormalLoopEnd = false;
           }
-          loopStack.pop();
         }
-        break;
-    }
-    irCode.push_back(cmd);
+        if (isNormalLoopEnd) {  // [->+>++<<]
+          std::map<int, int> deltaMap;
+          if (analyzeMultiplyLoop(irCode, loopStack.top() + 1, deltaMap)) {
+            irCode.erase(irCode.begin() + loopStack.top(), irCode.end());
+            loopStack.pop();
+            genMultiplyLoop(irCode, deltaMap);
+            return;
+          }
+        }
+        if (isNormalLoopEnd) {
+          cmd.type = BfInstruction::LOOP_END;
+          cmd.value1 = loopStack.top();
+          cmd.value2 = 0;
+          irCode[loopStack.top()].value1 = static_cast<int>(irCode.size());
+        }
+        loopStack.pop();
+      }
+      break;
   }
+  irCode.push_back(cmd);
 }
 
 
@@ -323,29 +441,20 @@ BfIRCompiler::compile(void)
 
 
 /*!
- * @brief Compress continuous instructions which has same meanings
- * @tparam [in] INST1  Instruction '+', '-', '>', '<'
- * @tparam [in] INST2  Instruction correspond to INST1, which has reverse meaning
- * @param srcptr  Pointer to Brainfuck source code
- * @return Compressed value
+ * @brief Get the Brainfuck-character which has the reverse meaning
+ * @param [in] command  Brainfuck-character
+ * @return Reverse of '+', '-', '>' and '<', otherwise '\0'
  */
-template<char INST1, char INST2>
-static int
-compressInstruction(const char **_srcptr)
+inline static char
+getReverseCommand(char command)
 {
-  const char *srcptr = *_srcptr;
-  int value = 0;
-  for (;; srcptr++) {
-    if (*srcptr == INST1) {
-      value++;
-    } else if (*srcptr == INST2) {
-      value--;
-    } else {
-      break;
-    }
+  switch (command) {
+    case '+': return '-';
+    case '-': return '+';
+    case '>': return '<';
+    case '<': return '>';
+    default:  return '\0';
   }
-  *_srcptr = srcptr - 1;
-  return value;
 }
 
 
@@ -377,9 +486,33 @@ genOperationAt(bf::BfInstruction::Command &cmd, const bf::BfInstruction::Command
       cmd.type = bf::BfInstruction::ASSIGN_AT;
       cmd.value2 = c1.value1;
       return false;
-    default:
-      return true;
+    case bf::BfInstruction::NEXT:
+    case bf::BfInstruction::PREV:
+    case bf::BfInstruction::NEXT_N:
+    case bf::BfInstruction::PREV_N:
+    case bf::BfInstruction::INC_AT:
+    case bf::BfInstruction::DEC_AT:
+    case bf::BfInstruction::ADD_AT:
+    case bf::BfInstruction::SUB_AT:
+    case bf::BfInstruction::PUTCHAR:
+    case bf::BfInstruction::GETCHAR:
+    case bf::BfInstruction::LOOP_START:
+    case bf::BfInstruction::LOOP_END:
+    case bf::BfInstruction::ASSIGN_AT:
+    case bf::BfInstruction::SEARCH_ZERO:
+    case bf::BfInstruction::ADD_VAR:
+    case bf::BfInstruction::SUB_VAR:
+    case bf::BfInstruction::CMUL_VAR:
+    case bf::BfInstruction::MULTI_CMUL_VAR:
+    case bf::BfInstruction::CMUL_TARGET:
+    case bf::BfInstruction::INF_LOOP:
+    case bf::BfInstruction::CHECK:
+    case bf::BfInstruction::PUTS:
+    case bf::BfInstruction::IF:
+    case bf::BfInstruction::END_IF:
+      break;
   }
+  return true;
 }
 
 
@@ -391,9 +524,189 @@ isPtrOperation(bf::BfInstruction::Instruction inst)
 }
 
 
-inline static bool
-isOperationAt(bf::BfInstruction::Instruction inst)
+/*!
+ * @brief Analyze whether the loop body is a multiply loop or not
+ *
+ * Multiply loop consists of only arithmetic operations at constant offsets,
+ * its pointer movement is balanced, and it decrements the loop counter by
+ * one in each iteration.
+ * @param [in]  irCode    Brainfuck IR code
+ * @param [in]  pos       Position of the first instruction of the loop body
+ * @param [out] deltaMap  Offset to amount of change per iteration, except for
+ *                        the loop counter
+ * @return true if the loop is a multiply loop, otherwise false
+ */
+static bool
+analyzeMultiplyLoop(const bf::BfIR &irCode, bf::BfIR::size_type pos, std::map<int, int> &deltaMap)
+{
+  int offset = 0;
+  for (bf::BfIR::const_iterator cmd = irCode.begin() + pos, end = irCode.end(); cmd != end; cmd++) {
+    switch (cmd->type) {
+      case bf::BfInstruction::NEXT:
+        offset++;
+        break;
+      case bf::BfInstruction::PREV:
+        offset--;
+        break;
+      case bf::BfInstruction::NEXT_N:
+        offset += cmd->value1;
+        break;
+      case bf::BfInstruction::PREV_N:
+        offset -= cmd->value1;
+        break;
+      case bf::BfInstruction::INC:
+        deltaMap[offset]++;
+        break;
+      case bf::BfInstruction::DEC:
+        deltaMap[offset]--;
+        break;
+      case bf::BfInstruction::ADD:
+        deltaMap[offset] += cmd->value1;
+        break;
+      case bf::BfInstruction::SUB:
+        deltaMap[offset] -= cmd->value1;
+        break;
+      case bf::BfInstruction::INC_AT:
+        deltaMap[offset + cmd->value1]++;
+        break;
+      case bf::BfInstruction::DEC_AT:
+        deltaMap[offset + cmd->value1]--;
+        break;
+      case bf::BfInstruction::ADD_AT:
+        deltaMap[offset + cmd->value1] += cmd->value2;
+        break;
+      case bf::BfInstruction::SUB_AT:
+        deltaMap[offset + cmd->value1] -= cmd->value2;
+        break;
+      case bf::BfInstruction::PUTCHAR:
+      case bf::BfInstruction::GETCHAR:
+      case bf::BfInstruction::LOOP_START:
+      case bf::BfInstruction::LOOP_END:
+      case bf::BfInstruction::ASSIGN_ZERO:
+      case bf::BfInstruction::ASSIGN:
+      case bf::BfInstruction::ASSIGN_AT:
+      case bf::BfInstruction::SEARCH_ZERO:
+      case bf::BfInstruction::ADD_VAR:
+      case bf::BfInstruction::SUB_VAR:
+      case bf::BfInstruction::CMUL_VAR:
+      case bf::BfInstruction::MULTI_CMUL_VAR:
+      case bf::BfInstruction::CMUL_TARGET:
+      case bf::BfInstruction::INF_LOOP:
+      case bf::BfInstruction::CHECK:
+      case bf::BfInstruction::PUTS:
+      case bf::BfInstruction::IF:
+      case bf::BfInstruction::END_IF:
+        return false;
+    }
+  }
+  std::map<int, int>::iterator counter = deltaMap.find(0);
+  if (offset != 0 || counter == deltaMap.end() || counter->second != -1) {
+    return false;
+  }
+  deltaMap.erase(counter);
+  for (std::map<int, int>::iterator itr = deltaMap.begin(); itr != deltaMap.end();) {
+    if (itr->second == 0) {
+      deltaMap.erase(itr++);
+    } else {
+      ++itr;
+    }
+  }
+  return true;
+}
+
+
+/*!
+ * @brief Append the instructions which are equivalent to the multiply loop
+ * @param [in,out] irCode    Brainfuck IR code
+ * @param [in]     deltaMap  Offset to amount of change per iteration
+ */
+static void
+genMultiplyLoop(bf::BfIR &irCode, const std::map<int, int> &deltaMap)
+{
+  bf::BfInstruction::Command cmd;
+  cmd.value2 = 0;
+  if (deltaMap.empty()) {
+    cmd.type = bf::BfInstruction::ASSIGN_ZERO;
+    cmd.value1 = 0;
+    irCode.push_back(cmd);
+  } else if (deltaMap.size() == 1) {
+    std::map<int, int>::const_iterator itr = deltaMap.begin();
+    cmd.value1 = itr->first;
+    if (itr->second == 1) {
+      cmd.type = bf::BfInstruction::ADD_VAR;
+    } else if (itr->second == -1) {
+      cmd.type = bf::BfInstruction::SUB_VAR;
+    } else {
+      cmd.type = bf::BfInstruction::CMUL_VAR;
+      cmd.value2 = itr->second;
+    }
+    irCode.push_back(cmd);
+  } else {
+    cmd.type = bf::BfInstruction::MULTI_CMUL_VAR;
+    cmd.value1 = static_cast<int>(deltaMap.size());
+    irCode.push_back(cmd);
+    cmd.type = bf::BfInstruction::CMUL_TARGET;
+    for (std::map<int, int>::const_iterator itr = deltaMap.begin(); itr != deltaMap.end(); ++itr) {
+      cmd.value1 = itr->first;
+      cmd.value2 = itr->second;
+      irCode.push_back(cmd);
+    }
+  }
+}
+
+
+/*!
+ * @brief Check whether any pointer movement or offset exceeds the limit
+ * @param [in] irCode  Brainfuck IR code
+ * @param [in] limit   Maximum absolute value of the pointer movements and the
+ *                     offsets
+ * @return true if any pointer movement or offset exceeds the limit
+ */
+static bool
+exceedsOffset(const bf::BfIR &irCode, int limit)
 {
-  return (inst == bf::BfInstruction::INC_AT || inst == bf::BfInstruction::DEC_AT ||
-      inst == bf::BfInstruction::ADD_AT || inst == bf::BfInstruction::SUB_AT);
+  for (bf::BfIR::const_iterator cmd = irCode.begin(), end = irCode.end(); cmd != end; cmd++) {
+    int offset;
+    switch (cmd->type) {
+      case bf::BfInstruction::NEXT_N:
+      case bf::BfInstruction::PREV_N:
+      case bf::BfInstruction::INC_AT:
+      case bf::BfInstruction::DEC_AT:
+      case bf::BfInstruction::ADD_AT:
+      case bf::BfInstruction::SUB_AT:
+      case bf::BfInstruction::PUTCHAR:
+      case bf::BfInstruction::GETCHAR:
+      case bf::BfInstruction::ASSIGN_AT:
+      case bf::BfInstruction::SEARCH_ZERO:
+      case bf::BfInstruction::ADD_VAR:
+      case bf::BfInstruction::SUB_VAR:
+      case bf::BfInstruction::CMUL_VAR:
+      case bf::BfInstruction::CMUL_TARGET:
+        offset = cmd->value1;
+        break;
+      case bf::BfInstruction::PUTS:
+        offset = cmd->value2;
+        break;
+      case bf::BfInstruction::NEXT:
+      case bf::BfInstruction::PREV:
+      case bf::BfInstruction::INC:
+      case bf::BfInstruction::DEC:
+      case bf::BfInstruction::ADD:
+      case bf::BfInstruction::SUB:
+      case bf::BfInstruction::LOOP_START:
+      case bf::BfInstruction::LOOP_END:
+      case bf::BfInstruction::ASSIGN_ZERO:
+      case bf::BfInstruction::ASSIGN:
+      case bf::BfInstruction::MULTI_CMUL_VAR:
+      case bf::BfInstruction::INF_LOOP:
+      case bf::BfInstruction::CHECK:
+      case bf::BfInstruction::IF:
+      case bf::BfInstruction::END_IF:
+        continue;
+    }
+    if (offset > limit || offset < -limit) {
+      return true;
+    }
+  }
+  return false;
 }
@@ -7,6 +7,8 @@
 #define BF_IR_COMPILER_H
 
 #include <cstdlib>
+#include <stack>
+#include <string>
 #include <vector>
 #include "compat.h"
 
@@ -16,6 +18,22 @@ namespace bf {
 
 /*!
  * @brief Brainfuck instruction set
+ *
+ * MULTI_CMUL_VAR is followed by value1 CMUL_TARGET instructions, each of
+ * which adds the current cell multiplied by value2 to the cell at offset
+ * value1.
+ * The current cell is cleared after all targets are updated.
+ * CHECK verifies that the cells from offset value1 to offset value2 are in
+ * the tape; it is inserted only when the bounds check is enabled.
+ * PUTS writes the string value1 of the string pool at once.
+ * The cell at offset value2 is assigned by the following instructions, so
+ * that a backend without a string output can print the string through it
+ * byte by byte.
+ * IF and END_IF form a loop which runs at most once, because the current
+ * cell is always zero at the end of its body; IF skips the body if the
+ * current cell is zero, and END_IF doesn't jump back.
+ * Like LOOP_START and LOOP_END, value1 of them is the position of each
+ * other.
  */
 class BfInstruction {
 public:
@@ -27,7 +45,9 @@ public:
     LOOP_START, LOOP_END,
     ASSIGN_ZERO, ASSIGN, ASSIGN_AT, SEARCH_ZERO,
     ADD_VAR, SUB_VAR, CMUL_VAR,
-    INF_LOOP
+    MULTI_CMUL_VAR, CMUL_TARGET,
+    INF_LOOP, CHECK, PUTS,
+    IF, END_IF
   } Instruction;
 
   struct Command {
@@ -38,15 +58,131 @@ public:
 };
 
 typedef std::vector<BfInstruction::Command> BfIR;
+typedef std::vector<std::string> BfStringPool;
+
+
+/*!
+ * @brief Reference-counted immutable Brainfuck-IR code
+ *
+ * Copying this object only increments the reference count, so that the
+ * compiled code can be shared among the interpreter, the JIT-compiler and
+ * the code generators without copying it.
+ */
+class BfIRModule {
+public:
+  BfIRModule(void) :
+    body(nullptr)
+  {}
+  /*!
+   * @brief Construct a module which takes over the content of irCode
+   * @param [in,out] irCode  Brainfuck-IR code, which is empty after this call
+   */
+  explicit BfIRModule(BfIR &irCode) :
+    body(new Body())
+  {
+    body->irCode.swap(irCode);
+  }
+  /*!
+   * @brief Construct a module which takes over irCode and its string pool
+   * @param [in,out] irCode   Brainfuck-IR code, which is empty after this call
+   * @param [in,out] strings  String pool, which is empty after this call
+   */
+  BfIRModule(BfIR &irCode, BfStringPool &strings) :
+    body(new Body())
+  {
+    body->irCode.swap(irCode);
+    body->strings.swap(strings);
+  }
+  BfIRModule(const BfIRModule &that) :
+    body(that.body)
+  {
+    retain();
+  }
+  ~BfIRModule(void)
+  {
+    release();
+  }
+
+  inline BfIRModule &
+  operator=(const BfIRModule &that)
+  {
+    if (body != that.body) {
+      release();
+      body = that.body;
+      retain();
+    }
+    return *this;
+  }
+  inline const BfIR &
+  getCode(void) const
+  {
+    static const BfIR EMPTY_CODE;
+    return body == nullptr ? EMPTY_CODE : body->irCode;
+  }
+  inline const BfStringPool &
+  getStrings(void) const
+  {
+    static const BfStringPool EMPTY_STRINGS;
+    return body == nullptr ? EMPTY_STRINGS : body->strings;
+  }
+  inline BfIR::size_type getSize(void) const { return getCode().size(); }
+  inline bool empty(void) const { return body == nullptr; }
+
+private:
+  struct Body {
+    BfIR irCode;
+    BfStringPool strings;
+    long refCount;
+    Body(void) :
+      irCode(),
+      strings(),
+      refCount(1)
+    {}
+  };
+  Body *body;
+
+  inline void
+  retain(void)
+  {
+    if (body != nullptr) {
+      body->refCount++;
+    }
+  }
+  inline void
+  release(void)
+  {
+    if (body != nullptr && --body->refCount == 0) {
+      delete body;
+    }
+    body = nullptr;
+  }
+};
 
 
 /*!
  * @brief Brainfuck to Brainfuck-IR compiler
+ *
+ * Source code is compiled at once with compile(), or chunk by chunk with
+ * reset(), feed() and finish(), so that the whole source code needn't be
+ * held in memory.
  */
 class BfIRCompiler {
 public:
+  //! Maximum pointer movement and offset of an instruction in cells
+  static const int MAX_OFFSET = 1 << 22;
+
   BfIRCompiler(const char* bfSource=nullptr) :
-    bfSource(bfSource)
+    bfSource(bfSource),
+    irModule(),
+    irCode(),
+    strings(),
+    loopStack(),
+    runCommand('\0'),
+    runValue(0),
+    memorySize(DEFAULT_MEMORY_SIZE),
+    boundsCheck(false),
+    offsetLimit(false),
+    prefixEvaluation(false)
   {}
 
   inline void
@@ -54,12 +190,60 @@ public:
     this->bfSource = bfSource;
   }
   void compile(void);
-  inline BfIR getCode(void) const { return irCode; };
-  inline BfIR::size_type getSize(void) const { return irCode.size(); };
+  void reset(void);
+  void feed(const char *data, std::size_t size);
+  void finish(void);
+  /*!
+   * @brief Enable or disable the bounds check of the tape
+   * @param [in] boundsCheck  If true, CHECK instructions are inserted
+   */
+  inline void setBoundsCheck(bool boundsCheck) { this->boundsCheck = boundsCheck; }
+  /*!
+   * @brief Enable or disable the limit of the pointer movement
+   *
+   * The limit is necessary only for the code which runs on BfTape.
+   * @param [in] offsetLimit  If true, the code whose pointer movement or
+   *                          offset exceeds MAX_OFFSET is rejected
+   */
+  inline void setOffsetLimit(bool offsetLimit) { this->offsetLimit = offsetLimit; }
+  /*!
+   * @brief Enable or disable the evaluation of the prefix of the code
+   *
+   * The evaluation is worth its cost only for the code which runs soon.
+   * @param [in] prefixEvaluation  If true, the prefix which doesn't depend on
+   *                               the input is evaluated at compile time
+   */
+  inline void setPrefixEvaluation(bool prefixEvaluation) { this->prefixEvaluation = prefixEvaluation; }
+  /*!
+   * @brief Set the number of the cells of the tape at runtime
+   *
+   * The prefix of the code is evaluated at compile time within this size,
+   * and the zero-filled tape is assumed by the optimizer unless it is 0.
+   * @param [in] memorySize  The number of the cells
+   */
+  inline void setMemorySize(std::size_t memorySize) { this->memorySize = memorySize; }
+  inline const BfIRModule &getModule(void) const { return irModule; };
+  inline const BfIR &getCode(void) const { return irModule.getCode(); };
+  inline BfIR::size_type getSize(void) const { return irModule.getSize(); };
 
 private:
+  static const std::size_t FEED_CHUNK_SIZE = 4096;
+  static const std::size_t DEFAULT_MEMORY_SIZE = 65536;
+
   const char* bfSource;
+  BfIRModule irModule;
   BfIR irCode;
+  BfStringPool strings;
+  std::stack<unsigned int> loopStack;
+  char runCommand;
+  int runValue;
+  std::size_t memorySize;
+  bool boundsCheck;
+  bool offsetLimit;
+  bool prefixEvaluation;
+
+  void flushRun(void);
+  void emit(char command, int value);
 };
 
 
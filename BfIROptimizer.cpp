@@ -0,0 +1,1299 @@
+/*!
+ * @file BfIROptimizer.cpp
+ * @brief Optimization passes for Brainfuck-IR
+ * @author koturn
+ */
+#include <stack>
+#include "BfIROptimizer.h"
+
+
+static inline bool
+isCellValue(long value);
+
+static inline bool
+isTrackedValue(long value);
+
+static inline bool
+hasSmallFactors(const bf::BfIR &irCode, const bf::BfInstruction::Command &cmd, bf::BfIR::size_type first, bf::BfIR::size_type last);
+
+
+namespace bf {
+
+
+const unsigned long BfIROptimizer::PREFIX_STEP_BUDGET;
+
+
+/*!
+ * @brief Sink pointer movement out of straight-line blocks
+ *
+ * Pointer movement in a block is accumulated into an offset, and every
+ * arithmetic, assign and I/O instruction in the block is rewritten to
+ * access the cell at that offset.
+ * The accumulated movement is emitted only once just before an instruction
+ * which depends on the current cell, such as loops and multiply loops.
+ * @param [in,out] irCode  Brainfuck IR code
+ */
+void
+BfIROptimizer::sinkPointerMotion(BfIR &irCode)
+{
+  BfIR optCode;
+  optCode.reserve(irCode.size());
+  int offset = 0;
+  for (BfIR::const_iterator itr = irCode.begin(), end = irCode.end(); itr != end; itr++) {
+    BfInstruction::Command cmd = *itr;
+    switch (cmd.type) {
+      case BfInstruction::NEXT:
+        offset++;
+        continue;
+      case BfInstruction::PREV:
+        offset--;
+        continue;
+      case BfInstruction::NEXT_N:
+        offset += cmd.value1;
+        continue;
+      case BfInstruction::PREV_N:
+        offset -= cmd.value1;
+        continue;
+      case BfInstruction::INC:
+        cmd.type = BfInstruction::INC_AT;
+        cmd.value1 = offset;
+        break;
+      case BfInstruction::DEC:
+        cmd.type = BfInstruction::DEC_AT;
+        cmd.value1 = offset;
+        break;
+      case BfInstruction::ADD:
+        cmd.type = BfInstruction::ADD_AT;
+        cmd.value2 = cmd.value1;
+        cmd.value1 = offset;
+        break;
+      case BfInstruction::SUB:
+        cmd.type = BfInstruction::SUB_AT;
+        cmd.value2 = cmd.value1;
+        cmd.value1 = offset;
+        break;
+      case BfInstruction::INC_AT:
+      case BfInstruction::DEC_AT:
+      case BfInstruction::ADD_AT:
+      case BfInstruction::SUB_AT:
+      case BfInstruction::ASSIGN_AT:
+        cmd.value1 += offset;
+        break;
+      case BfInstruction::ASSIGN_ZERO:
+        cmd.type = BfInstruction::ASSIGN_AT;
+        cmd.value1 = offset;
+        cmd.value2 = 0;
+        break;
+      case BfInstruction::ASSIGN:
+        cmd.type = BfInstruction::ASSIGN_AT;
+        cmd.value2 = cmd.value1;
+        cmd.value1 = offset;
+        break;
+      case BfInstruction::PUTCHAR:
+      case BfInstruction::GETCHAR:
+        cmd.value1 = offset;
+        break;
+      case BfInstruction::CMUL_TARGET:
+        break;
+      case BfInstruction::LOOP_START:
+      case BfInstruction::LOOP_END:
+      case BfInstruction::SEARCH_ZERO:
+      case BfInstruction::ADD_VAR:
+      case BfInstruction::SUB_VAR:
+      case BfInstruction::CMUL_VAR:
+      case BfInstruction::MULTI_CMUL_VAR:
+      case BfInstruction::INF_LOOP:
+      case BfInstruction::CHECK:
+      case BfInstruction::PUTS:
+      case BfInstruction::IF:
+      case BfInstruction::END_IF:
+        // These instructions depend on the current cell
+        genPointerMotion(optCode, offset);
+        offset = 0;
+        break;
+    }
+    normalizeOperationAt(cmd);
+    optCode.push_back(cmd);
+  }
+  relinkLoops(optCode);
+  irCode.swap(optCode);
+}
+
+
+/*!
+ * @brief Evaluate the prefix of the code which doesn't depend on the input
+ *
+ * The code is executed from the empty tape until the first GETCHAR, and the
+ * executed part is replaced with the code which prints the output and
+ * restores the tape at that point.
+ * The evaluation also stops when the step budget runs out, or before the
+ * instruction whose result is not determined at compile time: the access out
+ * of the tape and the cell which goes out of the range of 8-bit cell.
+ * If it stops in a loop, the state is rolled back to the end of the last
+ * completed instruction at the top level, so that the code restarts at the
+ * outermost loop.
+ * The budget is small, because the steps in the outermost loop are thrown
+ * away in that case.
+ * @param [in,out] irCode      Brainfuck IR code
+ * @param [in]     memorySize  The number of the cells of the tape at runtime
+ */
+void
+BfIROptimizer::evaluatePrefix(BfIR &irCode, std::size_t memorySize)
+{
+  PrefixState state;
+  BfIR::size_type pos = runPrefix(irCode, memorySize, state);
+  if (pos == 0) {
+    return;
+  }
+  BfIR residualCode;
+  genPrefixState(residualCode, state);
+  residualCode.insert(residualCode.end(), irCode.begin() + static_cast<std::ptrdiff_t>(pos), irCode.end());
+  relinkLoops(residualCode);
+  irCode.swap(residualCode);
+}
+
+
+/*!
+ * @brief Simplify the instructions on the cells whose values are known
+ *
+ * Values of the cells are tracked from the zero-filled tape through
+ * straight-line code, and across the loops which don't move the pointer by
+ * forgetting only the cells written in the loop.
+ * The current cell is known to be zero after loops, SEARCH_ZERO and
+ * multiply loops.
+ * Loops and multiply loops on the zero cell and assignments of the same
+ * value are removed, and arithmetic on the known cells is replaced with
+ * assignments.
+ * Loops whose bodies always end on the zero cell are lowered to IF and
+ * END_IF.
+ * @param [in,out] irCode      Brainfuck IR code
+ * @param [in]     memorySize  The number of the cells of the tape at runtime;
+ *                             0 means that the initial tape is not known
+ */
+void
+BfIROptimizer::propagateKnownValues(BfIR &irCode, std::size_t memorySize)
+{
+  BfIR optCode;
+  optCode.reserve(irCode.size());
+  KnownCells cells(memorySize);
+  genKnownValueCode(optCode, irCode, 0, irCode.size(), cells);
+  relinkLoops(optCode);
+  irCode.swap(optCode);
+}
+
+
+/*!
+ * @brief Merge the output of the constant bytes into PUTS instructions
+ *
+ * In each straight-line block of arithmetic, assign and PUTCHAR
+ * instructions, the cells which are assigned in the block are tracked at
+ * compile time.
+ * The instructions on these cells are removed, consecutive PUTCHARs of them
+ * are merged into one PUTS, and the final values of the cells are assigned
+ * at the end of the block.
+ * The merged output is written before the instructions on the other cells,
+ * so that it is not lost when they overflow the tape.
+ * @param [in,out] irCode   Brainfuck IR code
+ * @param [out]    strings  String pool which PUTS instructions refer to
+ */
+void
+BfIROptimizer::coalesceOutput(BfIR &irCode, BfStringPool &strings)
+{
+  BfIR optCode;
+  optCode.reserve(irCode.size());
+  std::map<int, int> knownCells;
+  std::string pendingOutput;
+  int scratchOffset = 0;
+  for (BfIR::const_iterator itr = irCode.begin(), end = irCode.end(); itr != end; itr++) {
+    BfInstruction::Command cmd = *itr;
+    int at = cmd.value1;
+    int delta = 0;
+    switch (cmd.type) {
+      case BfInstruction::INC:
+        at = 0;
+        delta = 1;
+        break;
+      case BfInstruction::DEC:
+        at = 0;
+        delta = -1;
+        break;
+      case BfInstruction::ADD:
+        at = 0;
+        delta = cmd.value1;
+        break;
+      case BfInstruction::SUB:
+        at = 0;
+        delta = -cmd.value1;
+        break;
+      case BfInstruction::INC_AT:
+        delta = 1;
+        break;
+      case BfInstruction::DEC_AT:
+        delta = -1;
+        break;
+      case BfInstruction::ADD_AT:
+        delta = cmd.value2;
+        break;
+      case BfInstruction::SUB_AT:
+        delta = -cmd.value2;
+        break;
+      case BfInstruction::ASSIGN_ZERO:
+        knownCells[0] = 0;
+        continue;
+      case BfInstruction::ASSIGN:
+        knownCells[0] = cmd.value1;
+        continue;
+      case BfInstruction::ASSIGN_AT:
+        knownCells[cmd.value1] = cmd.value2;
+        continue;
+      case BfInstruction::PUTCHAR:
+        {
+          std::map<int, int>::const_iterator cell = knownCells.find(cmd.value1);
+          if (cell == knownCells.end()) {
+            genPuts(optCode, strings, pendingOutput, scratchOffset);
+            optCode.push_back(cmd);
+          } else {
+            if (pendingOutput.empty()) {
+              scratchOffset = cmd.value1;
+            }
+            pendingOutput += static_cast<char>(cell->second & 0xff);
+          }
+        }
+        continue;
+      case BfInstruction::NEXT:
+      case BfInstruction::PREV:
+      case BfInstruction::NEXT_N:
+      case BfInstruction::PREV_N:
+      case BfInstruction::GETCHAR:
+      case BfInstruction::LOOP_START:
+      case BfInstruction::LOOP_END:
+      case BfInstruction::SEARCH_ZERO:
+      case BfInstruction::ADD_VAR:
+      case BfInstruction::SUB_VAR:
+      case BfInstruction::CMUL_VAR:
+      case BfInstruction::MULTI_CMUL_VAR:
+      case BfInstruction::CMUL_TARGET:
+      case BfInstruction::INF_LOOP:
+      case BfInstruction::CHECK:
+      case BfInstruction::PUTS:
+      case BfInstruction::IF:
+      case BfInstruction::END_IF:
+        // The block ends before the other instructions
+        genKnownCells(optCode, strings, knownCells, pendingOutput, scratchOffset);
+        optCode.push_back(cmd);
+        continue;
+    }
+    std::map<int, int>::iterator cell = knownCells.find(at);
+    if (cell == knownCells.end()) {
+      genPuts(optCode, strings, pendingOutput, scratchOffset);
+      optCode.push_back(cmd);
+    } else {
+      cell->second += delta;
+    }
+  }
+  genKnownCells(optCode, strings, knownCells, pendingOutput, scratchOffset);
+  relinkLoops(optCode);
+  irCode.swap(optCode);
+}
+
+
+/*!
+ * @brief Insert CHECK instructions which guard the accesses to the tape
+ *
+ * Code is split into segments at the instructions whose pointer movement is
+ * unknown at compile time: SEARCH_ZERO and the loops which move the pointer,
+ * and after I/O instructions, so that the check doesn't fail before the I/O
+ * which precedes the overflow.
+ * Each segment is guarded by one CHECK at its head, which covers all the
+ * accesses in the segment, including the loops which don't move the pointer.
+ * So the loops which neither move the pointer nor do I/O are checked once at
+ * the entry, and the other loops are checked once per iteration.
+ * @param [in,out] irCode  Brainfuck IR code
+ */
+void
+BfIROptimizer::insertBoundsChecks(BfIR &irCode)
+{
+  BfIR checkedCode;
+  checkedCode.reserve(irCode.size() + irCode.size() / 4 + 1);
+  genCheckedCode(checkedCode, irCode, 0, irCode.size(), false);
+  relinkLoops(checkedCode);
+  irCode.swap(checkedCode);
+}
+
+
+/*!
+ * @brief Recalculate jump targets of LOOP_START, LOOP_END, IF and END_IF
+ * @param [in,out] irCode  Brainfuck IR code
+ */
+void
+BfIROptimizer::relinkLoops(BfIR &irCode)
+{
+  std::stack<int> loopStack;
+  for (BfIR::size_type i = 0; i < irCode.size(); i++) {
+    if (irCode[i].type == BfInstruction::LOOP_START || irCode[i].type == BfInstruction::IF) {
+      loopStack.push(static_cast<int>(i));
+    } else if (irCode[i].type == BfInstruction::LOOP_END || irCode[i].type == BfInstruction::END_IF) {
+      irCode[i].value1 = loopStack.top();
+      irCode[loopStack.top()].value1 = static_cast<int>(i);
+      loopStack.pop();
+    }
+  }
+}
+
+
+
+
+/* ========================================================================= *
+ * Private members                                                           *
+ * ========================================================================= */
+/*!
+ * @brief Append the instruction which moves the pointer
+ * @param [in,out] irCode  Brainfuck IR code
+ * @param [in]     offset  Amount of the pointer movement
+ */
+void
+BfIROptimizer::genPointerMotion(BfIR &irCode, int offset)
+{
+  BfInstruction::Command cmd;
+  cmd.value2 = 0;
+  if (offset > 0) {
+    cmd.type = offset == 1 ? BfInstruction::NEXT : BfInstruction::NEXT_N;
+    cmd.value1 = offset == 1 ? 0 : offset;
+  } else if (offset < 0) {
+    cmd.type = offset == -1 ? BfInstruction::PREV : BfInstruction::PREV_N;
+    cmd.value1 = offset == -1 ? 0 : -offset;
+  } else {
+    return;
+  }
+  irCode.push_back(cmd);
+}
+
+
+/*!
+ * @brief Execute the code from the start as far as possible
+ * @param [in]  irCode      Brainfuck IR code
+ * @param [in]  memorySize  The number of the cells of the tape at runtime
+ * @param [out] state       State after the executed instructions
+ * @return Position of the first instruction which is not executed
+ */
+BfIR::size_type
+BfIROptimizer::runPrefix(const BfIR &irCode, std::size_t memorySize, PrefixState &state)
+{
+  BfIR::size_type checkpointPos = 0;
+  unsigned long steps = 0;
+  int depth = 0;
+  BfIR::size_type pos = 0;
+  for (; pos < irCode.size() && ++steps <= PREFIX_STEP_BUDGET; pos++) {
+    const BfInstruction::Command &cmd = irCode[pos];
+    if (cmd.type != BfInstruction::LOOP_START && cmd.type != BfInstruction::LOOP_END) {
+      if (!stepPrefix(irCode, pos, memorySize, state, steps)) {
+        break;
+      }
+      continue;
+    }
+    int *cell = state.getCell(0, memorySize);
+    BfIR::size_type target = static_cast<BfIR::size_type>(cmd.value1);
+    if (cell == nullptr || target >= irCode.size()
+        || irCode[target].type != (cmd.type == BfInstruction::LOOP_START ? BfInstruction::LOOP_END : BfInstruction::LOOP_START)) {
+      // Unmatched bracket
+      break;
+    }
+    if (cmd.type == BfInstruction::LOOP_START) {
+      if (*cell == 0) {
+        pos = target;
+      } else if (depth++ == 0) {
+        state.setCheckpoint();
+        checkpointPos = pos;
+      }
+    } else {
+      if (*cell != 0) {
+        pos = target;
+      } else if (--depth == 0) {
+        state.clearCheckpoint();
+      }
+    }
+  }
+  if (pos < irCode.size() && depth > 0) {
+    state.rollback();
+    return checkpointPos;
+  }
+  return pos;
+}
+
+
+/*!
+ * @brief Execute one instruction other than the loops
+ *
+ * The state is not changed if the instruction can't be executed, except for
+ * SEARCH_ZERO, which can restart from the cell where it stopped.
+ * @param [in]     irCode      Brainfuck IR code
+ * @param [in,out] pos         Position of the instruction, which is moved to
+ *                             the last CMUL_TARGET of MULTI_CMUL_VAR
+ * @param [in]     memorySize  The number of the cells of the tape at runtime
+ * @param [in,out] state       State of the tape and the output
+ * @param [in,out] steps       The number of executed steps
+ * @return true if the instruction is executed, otherwise false
+ */
+bool
+BfIROptimizer::stepPrefix(const BfIR &irCode, BfIR::size_type &pos, std::size_t memorySize, PrefixState &state, unsigned long &steps)
+{
+  const BfInstruction::Command &cmd = irCode[pos];
+  int offset = 0;
+  long delta = 0;
+  switch (cmd.type) {
+    case BfInstruction::NEXT:
+      state.pos++;
+      return true;
+    case BfInstruction::PREV:
+      state.pos--;
+      return true;
+    case BfInstruction::NEXT_N:
+      state.pos += cmd.value1;
+      return true;
+    case BfInstruction::PREV_N:
+      state.pos -= cmd.value1;
+      return true;
+    case BfInstruction::INC:
+      delta = 1;
+      break;
+    case BfInstruction::DEC:
+      delta = -1;
+      break;
+    case BfInstruction::ADD:
+      delta = cmd.value1;
+      break;
+    case BfInstruction::SUB:
+      delta = -static_cast<long>(cmd.value1);
+      break;
+    case BfInstruction::INC_AT:
+      offset = cmd.value1;
+      delta = 1;
+      break;
+    case BfInstruction::DEC_AT:
+      offset = cmd.value1;
+      delta = -1;
+      break;
+    case BfInstruction::ADD_AT:
+      offset = cmd.value1;
+      delta = cmd.value2;
+      break;
+    case BfInstruction::SUB_AT:
+      offset = cmd.value1;
+      delta = -static_cast<long>(cmd.value2);
+      break;
+    case BfInstruction::ASSIGN_ZERO:
+    case BfInstruction::ASSIGN:
+    case BfInstruction::ASSIGN_AT:
+      {
+        bool isAt = cmd.type == BfInstruction::ASSIGN_AT;
+        int value = cmd.type == BfInstruction::ASSIGN_ZERO ? 0 : isAt ? cmd.value2 : cmd.value1;
+        int *cell = state.getCell(isAt ? cmd.value1 : 0, memorySize);
+        if (cell == nullptr || !isCellValue(value)) {
+          return false;
+        }
+        *cell = value;
+      }
+      return true;
+    case BfInstruction::PUTCHAR:
+      {
+        int *cell = state.getCell(cmd.value1, memorySize);
+        if (cell == nullptr) {
+          return false;
+        }
+        state.output += static_cast<char>(*cell);
+      }
+      return true;
+    case BfInstruction::GETCHAR:
+    case BfInstruction::PUTS:
+      // PUTS is generated after the evaluation
+      return false;
+    case BfInstruction::SEARCH_ZERO:
+      for (;;) {
+        int *cell = state.getCell(0, memorySize);
+        if (cell == nullptr || ++steps > PREFIX_STEP_BUDGET) {
+          return false;
+        } else if (*cell == 0) {
+          return true;
+        }
+        state.pos += cmd.value1;
+      }
+    case BfInstruction::ADD_VAR:
+    case BfInstruction::SUB_VAR:
+    case BfInstruction::CMUL_VAR:
+    case BfInstruction::MULTI_CMUL_VAR:
+      {
+        // The pointer to the cell is invalidated when the tape grows
+        int *cell = state.getCell(0, memorySize);
+        if (cell == nullptr) {
+          return false;
+        }
+        int current = *cell;
+        BfIR::size_type first = pos;
+        BfIR::size_type last = pos;
+        if (cmd.type == BfInstruction::MULTI_CMUL_VAR) {
+          first = pos + 1;
+          last = pos + static_cast<BfIR::size_type>(cmd.value1);
+        }
+        // Test all targets before updating them
+        for (int isUpdate = 0; isUpdate < 2; isUpdate++) {
+          for (BfIR::size_type i = first; i <= last; i++) {
+            int factor = cmd.type == BfInstruction::ADD_VAR ? 1
+              : cmd.type == BfInstruction::SUB_VAR ? -1
+              : irCode[i].value2;
+            int *target = state.getCell(irCode[i].value1, memorySize);
+            if (current != 0 && (factor > 255 || factor < -255)) {
+              return false;
+            }
+            long value = target == nullptr ? -1 : *target + static_cast<long>(current) * factor;
+            if (isUpdate) {
+              *target = static_cast<int>(value);
+            } else if (!isCellValue(value)) {
+              return false;
+            }
+          }
+        }
+        *state.getCell(0, memorySize) = 0;
+        pos = last;
+      }
+      return true;
+    case BfInstruction::CMUL_TARGET:
+    case BfInstruction::CHECK:
+      return true;
+    case BfInstruction::INF_LOOP:
+      {
+        int *cell = state.getCell(0, memorySize);
+        return cell != nullptr && *cell == 0;
+      }
+    case BfInstruction::LOOP_START:
+    case BfInstruction::LOOP_END:
+    case BfInstruction::IF:
+    case BfInstruction::END_IF:
+      return false;
+  }
+  int *cell = state.getCell(offset, memorySize);
+  if (cell == nullptr || !isCellValue(*cell + delta)) {
+    return false;
+  }
+  *cell = static_cast<int>(*cell + delta);
+  return true;
+}
+
+
+/*!
+ * @brief Append the instructions which reproduce the state
+ *
+ * The output is printed through the cell at the origin before the tape is
+ * restored.
+ * @param [in,out] irCode  Brainfuck IR code
+ * @param [in]     state   State of the tape and the output
+ */
+void
+BfIROptimizer::genPrefixState(BfIR &irCode, const PrefixState &state)
+{
+  BfInstruction::Command cmd;
+  for (std::string::const_iterator itr = state.output.begin(), end = state.output.end(); itr != end; itr++) {
+    cmd.type = BfInstruction::ASSIGN;
+    cmd.value1 = static_cast<unsigned char>(*itr);
+    cmd.value2 = 0;
+    irCode.push_back(cmd);
+    cmd.type = BfInstruction::PUTCHAR;
+    cmd.value1 = 0;
+    irCode.push_back(cmd);
+  }
+  for (std::vector<int>::size_type i = 0; i < state.tape.size(); i++) {
+    if (state.tape[i] != 0 || (i == 0 && !state.output.empty())) {
+      cmd.type = BfInstruction::ASSIGN_AT;
+      cmd.value1 = static_cast<int>(i);
+      cmd.value2 = state.tape[i];
+      normalizeOperationAt(cmd);
+      irCode.push_back(cmd);
+    }
+  }
+  genPointerMotion(irCode, static_cast<int>(state.pos));
+}
+
+
+/*!
+ * @brief Append the instructions simplified with the known values of cells
+ * @param [in,out] optCode  Destination Brainfuck IR code
+ * @param [in]     irCode   Source Brainfuck IR code
+ * @param [in]     pos      Position of the first instruction
+ * @param [in]     end      Position of the end of the instructions
+ * @param [in,out] cells    Known values of the cells
+ */
+void
+BfIROptimizer::genKnownValueCode(BfIR &optCode, const BfIR &irCode, BfIR::size_type pos, BfIR::size_type end, KnownCells &cells)
+{
+  for (; pos < end; pos++) {
+    const BfInstruction::Command &cmd = irCode[pos];
+    int value;
+    switch (cmd.type) {
+      case BfInstruction::NEXT:
+        cells.move(1);
+        break;
+      case BfInstruction::PREV:
+        cells.move(-1);
+        break;
+      case BfInstruction::NEXT_N:
+        cells.move(cmd.value1);
+        break;
+      case BfInstruction::PREV_N:
+        cells.move(-cmd.value1);
+        break;
+      case BfInstruction::INC:
+        genAddAtKnown(optCode, cells, 0, 1);
+        continue;
+      case BfInstruction::DEC:
+        genAddAtKnown(optCode, cells, 0, -1);
+        continue;
+      case BfInstruction::ADD:
+        genAddAtKnown(optCode, cells, 0, cmd.value1);
+        continue;
+      case BfInstruction::SUB:
+        genAddAtKnown(optCode, cells, 0, -static_cast<long>(cmd.value1));
+        continue;
+      case BfInstruction::INC_AT:
+        genAddAtKnown(optCode, cells, cmd.value1, 1);
+        continue;
+      case BfInstruction::DEC_AT:
+        genAddAtKnown(optCode, cells, cmd.value1, -1);
+        continue;
+      case BfInstruction::ADD_AT:
+        genAddAtKnown(optCode, cells, cmd.value1, cmd.value2);
+        continue;
+      case BfInstruction::SUB_AT:
+        genAddAtKnown(optCode, cells, cmd.value1, -static_cast<long>(cmd.value2));
+        continue;
+      case BfInstruction::ASSIGN_ZERO:
+      case BfInstruction::ASSIGN:
+      case BfInstruction::ASSIGN_AT:
+        {
+          int offset = cmd.type == BfInstruction::ASSIGN_AT ? cmd.value1 : 0;
+          int newValue = cmd.type == BfInstruction::ASSIGN_AT ? cmd.value2
+            : cmd.type == BfInstruction::ASSIGN ? cmd.value1
+            : 0;
+          if (cells.get(offset, value) && value == newValue) {
+            continue;
+          }
+          cells.set(offset, newValue);
+        }
+        break;
+      case BfInstruction::PUTCHAR:
+      case BfInstruction::PUTS:
+      case BfInstruction::CHECK:
+        break;
+      case BfInstruction::GETCHAR:
+        cells.forget(cmd.value1);
+        break;
+      case BfInstruction::LOOP_START:
+      case BfInstruction::IF:
+        {
+          BfIR::size_type loopEnd = static_cast<BfIR::size_type>(cmd.value1);
+          if (loopEnd <= pos) {
+            // Unmatched loop is left as it is
+            cells.forgetAll();
+            optCode.insert(optCode.end(), irCode.begin() + static_cast<std::ptrdiff_t>(pos), irCode.begin() + static_cast<std::ptrdiff_t>(end));
+            return;
+          }
+          if (cells.get(0, value) && value == 0) {
+            pos = loopEnd;
+            continue;
+          }
+          std::set<int> written;
+          if (collectWrittenCells(irCode, pos + 1, loopEnd, written)) {
+            for (std::set<int>::const_iterator itr = written.begin(); itr != written.end(); itr++) {
+              cells.forget(*itr);
+            }
+            cells.forget(0);
+          } else {
+            cells.forgetAll();
+          }
+          // Every iteration starts with the same known cells
+          KnownCells bodyCells(cells);
+          BfIR::size_type loopStart = optCode.size();
+          optCode.push_back(cmd);
+          genKnownValueCode(optCode, irCode, pos + 1, loopEnd, bodyCells);
+          optCode.push_back(irCode[loopEnd]);
+          if (bodyCells.get(0, value) && value == 0) {
+            // The loop never jumps back
+            optCode[loopStart].type = BfInstruction::IF;
+            optCode.back().type = BfInstruction::END_IF;
+          }
+          cells.set(0, 0);
+          pos = loopEnd;
+        }
+        continue;
+      case BfInstruction::LOOP_END:
+      case BfInstruction::END_IF:
+        break;
+      case BfInstruction::SEARCH_ZERO:
+        if (cells.get(0, value) && value == 0) {
+          continue;
+        }
+        optCode.push_back(cmd);
+        cells.forgetAll();
+        cells.set(0, 0);
+        continue;
+      case BfInstruction::ADD_VAR:
+      case BfInstruction::SUB_VAR:
+      case BfInstruction::CMUL_VAR:
+      case BfInstruction::MULTI_CMUL_VAR:
+        {
+          BfIR::size_type first = pos;
+          BfIR::size_type last = pos;
+          if (cmd.type == BfInstruction::MULTI_CMUL_VAR) {
+            first = pos + 1;
+            last = pos + static_cast<BfIR::size_type>(cmd.value1);
+          }
+          if (cells.get(0, value) && isCellValue(value) && hasSmallFactors(irCode, cmd, first, last)) {
+            // Unrolled into the additions to the targets
+            for (BfIR::size_type i = first; i <= last; i++) {
+              long factor = cmd.type == BfInstruction::ADD_VAR ? 1
+                : cmd.type == BfInstruction::SUB_VAR ? -1
+                : irCode[i].value2;
+              genAddAtKnown(optCode, cells, irCode[i].value1, factor * value);
+            }
+            if (value != 0) {
+              genAssignAt(optCode, 0, 0);
+              cells.set(0, 0);
+            }
+          } else {
+            for (BfIR::size_type i = first; i <= last; i++) {
+              cells.forget(irCode[i].value1);
+            }
+            optCode.insert(optCode.end(), irCode.begin() + static_cast<std::ptrdiff_t>(pos), irCode.begin() + static_cast<std::ptrdiff_t>(last + 1));
+            cells.set(0, 0);
+          }
+          pos = last;
+        }
+        continue;
+      case BfInstruction::CMUL_TARGET:
+        break;
+      case BfInstruction::INF_LOOP:
+        if (cells.get(0, value) && value == 0) {
+          continue;
+        }
+        cells.set(0, 0);
+        break;
+    }
+    optCode.push_back(cmd);
+  }
+}
+
+
+/*!
+ * @brief Append the addition to the cell, which is an assignment if the
+ *        value of the cell is known
+ * @param [in,out] optCode  Brainfuck IR code
+ * @param [in,out] cells    Known values of the cells
+ * @param [in]     offset   Offset of the cell
+ * @param [in]     delta    Amount of the addition
+ */
+void
+BfIROptimizer::genAddAtKnown(BfIR &optCode, KnownCells &cells, int offset, long delta)
+{
+  int value;
+  if (delta == 0) {
+    return;
+  } else if (!cells.get(offset, value) || !isTrackedValue(value + delta)) {
+    cells.forget(offset);
+    genAddAt(optCode, offset, delta);
+  } else if (isCellValue(value + delta)) {
+    cells.set(offset, static_cast<int>(value + delta));
+    genAssignAt(optCode, offset, static_cast<int>(value + delta));
+  } else {
+    cells.set(offset, static_cast<int>(value + delta));
+    genAddAt(optCode, offset, delta);
+  }
+}
+
+
+/*!
+ * @brief Collect the offsets of the cells which are written in the loop body
+ * @param [in]  irCode   Brainfuck IR code
+ * @param [in]  pos      Position of the first instruction of the loop body
+ * @param [in]  end      Position of LOOP_END
+ * @param [out] written  Offsets of the written cells
+ * @return true if the loop body doesn't move the pointer, otherwise false
+ */
+bool
+BfIROptimizer::collectWrittenCells(const BfIR &irCode, BfIR::size_type pos, BfIR::size_type end, std::set<int> &written)
+{
+  int offset = 0;
+  for (; pos < end; pos++) {
+    const BfInstruction::Command &cmd = irCode[pos];
+    switch (cmd.type) {
+      case BfInstruction::NEXT:
+        offset++;
+        break;
+      case BfInstruction::PREV:
+        offset--;
+        break;
+      case BfInstruction::NEXT_N:
+        offset += cmd.value1;
+        break;
+      case BfInstruction::PREV_N:
+        offset -= cmd.value1;
+        break;
+      case BfInstruction::INC:
+      case BfInstruction::DEC:
+      case BfInstruction::ADD:
+      case BfInstruction::SUB:
+      case BfInstruction::ASSIGN_ZERO:
+      case BfInstruction::ASSIGN:
+      case BfInstruction::MULTI_CMUL_VAR:
+        written.insert(offset);
+        break;
+      case BfInstruction::INC_AT:
+      case BfInstruction::DEC_AT:
+      case BfInstruction::ADD_AT:
+      case BfInstruction::SUB_AT:
+      case BfInstruction::ASSIGN_AT:
+      case BfInstruction::GETCHAR:
+      case BfInstruction::CMUL_TARGET:
+        written.insert(offset + cmd.value1);
+        break;
+      case BfInstruction::ADD_VAR:
+      case BfInstruction::SUB_VAR:
+      case BfInstruction::CMUL_VAR:
+        written.insert(offset);
+        written.insert(offset + cmd.value1);
+        break;
+      case BfInstruction::PUTS:
+        // The scratch cell may be written by the backend
+        written.insert(offset + cmd.value2);
+        break;
+      case BfInstruction::LOOP_START:
+      case BfInstruction::IF:
+        {
+          BfIR::size_type loopEnd = static_cast<BfIR::size_type>(cmd.value1);
+          std::set<int> body;
+          if (loopEnd <= pos || !collectWrittenCells(irCode, pos + 1, loopEnd, body)) {
+            return false;
+          }
+          for (std::set<int>::const_iterator itr = body.begin(); itr != body.end(); itr++) {
+            written.insert(offset + *itr);
+          }
+          written.insert(offset);
+          pos = loopEnd;
+        }
+        break;
+      case BfInstruction::SEARCH_ZERO:
+        return false;
+      case BfInstruction::PUTCHAR:
+      case BfInstruction::LOOP_END:
+      case BfInstruction::END_IF:
+      case BfInstruction::INF_LOOP:
+      case BfInstruction::CHECK:
+        break;
+    }
+  }
+  return offset == 0;
+}
+
+
+/*!
+ * @brief Append the assignment which doesn't depend on the width of the cell
+ *
+ * The value out of the range of 8-bit cell is assigned as the nearest value
+ * in the range followed by the addition of the rest.
+ * @param [in,out] irCode  Brainfuck IR code
+ * @param [in]     offset  Offset of the cell
+ * @param [in]     value   Value of the cell
+ */
+void
+BfIROptimizer::genAssignAt(BfIR &irCode, int offset, int value)
+{
+  int base = value < 0 ? 0 : value > 255 ? 255 : value;
+  BfInstruction::Command cmd;
+  cmd.type = BfInstruction::ASSIGN_AT;
+  cmd.value1 = offset;
+  cmd.value2 = base;
+  normalizeOperationAt(cmd);
+  irCode.push_back(cmd);
+  genAddAt(irCode, offset, static_cast<long>(value) - base);
+}
+
+
+/*!
+ * @brief Append the addition to the cell
+ * @param [in,out] irCode  Brainfuck IR code
+ * @param [in]     offset  Offset of the cell
+ * @param [in]     delta   Amount of the addition, which is truncated to int
+ */
+void
+BfIROptimizer::genAddAt(BfIR &irCode, int offset, long delta)
+{
+  if (delta == 0) {
+    return;
+  }
+  BfInstruction::Command cmd;
+  cmd.value1 = offset;
+  if (delta == 1 || delta == -1) {
+    cmd.type = delta > 0 ? BfInstruction::INC_AT : BfInstruction::DEC_AT;
+    cmd.value2 = 0;
+  } else {
+    cmd.type = delta > 0 ? BfInstruction::ADD_AT : BfInstruction::SUB_AT;
+    cmd.value2 = static_cast<int>(delta > 0 ? delta : -delta);
+  }
+  normalizeOperationAt(cmd);
+  irCode.push_back(cmd);
+}
+
+
+/*!
+ * @brief Append the pending output and the assignments of the known cells
+ * @param [in,out] irCode         Brainfuck IR code
+ * @param [in,out] strings        String pool
+ * @param [in,out] knownCells     Values of the cells which are known at
+ *                                compile time, which is cleared
+ * @param [in,out] pendingOutput  Output which is not appended yet, which is
+ *                                cleared
+ * @param [in]     scratchOffset  Offset of the cell which is assigned in the
+ *                                following instructions
+ */
+void
+BfIROptimizer::genKnownCells(BfIR &irCode, BfStringPool &strings, std::map<int, int> &knownCells, std::string &pendingOutput, int scratchOffset)
+{
+  genPuts(irCode, strings, pendingOutput, scratchOffset);
+  for (std::map<int, int>::const_iterator itr = knownCells.begin(), end = knownCells.end(); itr != end; itr++) {
+    genAssignAt(irCode, itr->first, itr->second);
+  }
+  knownCells.clear();
+}
+
+
+/*!
+ * @brief Append PUTS instruction of the pending output
+ * @param [in,out] irCode         Brainfuck IR code
+ * @param [in,out] strings        String pool
+ * @param [in,out] pendingOutput  Output which is not appended yet, which is
+ *                                cleared
+ * @param [in]     scratchOffset  Offset of the cell which is assigned in the
+ *                                following instructions
+ */
+void
+BfIROptimizer::genPuts(BfIR &irCode, BfStringPool &strings, std::string &pendingOutput, int scratchOffset)
+{
+  if (pendingOutput.empty()) {
+    return;
+  }
+  BfInstruction::Command cmd;
+  cmd.type = BfInstruction::PUTS;
+  cmd.value1 = static_cast<int>(strings.size());
+  cmd.value2 = scratchOffset;
+  irCode.push_back(cmd);
+  strings.push_back(std::string());
+  strings.back().swap(pendingOutput);
+}
+
+
+/*!
+ * @brief Compute the range of the cells which are accessed by the instructions
+ *
+ * The scan stops at SEARCH_ZERO, the loop which moves the pointer and I/O
+ * instructions, and the cell which is accessed by the instruction is
+ * included in the range.
+ * @param [in]     irCode  Brainfuck IR code
+ * @param [in]     pos     Position of the first instruction
+ * @param [in]     end     Position of the end of the scan
+ * @param [in,out] range   Range of the accessed cells
+ * @return Position where the scan stopped, or end
+ */
+BfIR::size_type
+BfIROptimizer::scanAccessRange(const BfIR &irCode, BfIR::size_type pos, BfIR::size_type end, AccessRange &range)
+{
+  for (; pos < end; pos++) {
+    const BfInstruction::Command &cmd = irCode[pos];
+    switch (cmd.type) {
+      case BfInstruction::NEXT:
+        range.offset++;
+        break;
+      case BfInstruction::PREV:
+        range.offset--;
+        break;
+      case BfInstruction::NEXT_N:
+        range.offset += cmd.value1;
+        break;
+      case BfInstruction::PREV_N:
+        range.offset -= cmd.value1;
+        break;
+      case BfInstruction::INC:
+      case BfInstruction::DEC:
+      case BfInstruction::ADD:
+      case BfInstruction::SUB:
+      case BfInstruction::ASSIGN_ZERO:
+      case BfInstruction::ASSIGN:
+      case BfInstruction::MULTI_CMUL_VAR:
+      case BfInstruction::INF_LOOP:
+        range.access(0);
+        break;
+      case BfInstruction::INC_AT:
+      case BfInstruction::DEC_AT:
+      case BfInstruction::ADD_AT:
+      case BfInstruction::SUB_AT:
+      case BfInstruction::ASSIGN_AT:
+      case BfInstruction::CMUL_TARGET:
+        range.access(cmd.value1);
+        break;
+      case BfInstruction::PUTCHAR:
+      case BfInstruction::GETCHAR:
+        range.access(cmd.value1);
+        return pos;
+      case BfInstruction::PUTS:
+        // The scratch cell may be written by the backend
+        range.access(cmd.value2);
+        return pos;
+      case BfInstruction::ADD_VAR:
+      case BfInstruction::SUB_VAR:
+      case BfInstruction::CMUL_VAR:
+        range.access(0);
+        range.access(cmd.value1);
+        break;
+      case BfInstruction::SEARCH_ZERO:
+        range.access(0);
+        return pos;
+      case BfInstruction::LOOP_START:
+      case BfInstruction::IF:
+        {
+          BfIR::size_type loopEnd = static_cast<BfIR::size_type>(cmd.value1);
+          AccessRange body;
+          range.access(0);
+          if (scanAccessRange(irCode, pos + 1, loopEnd, body) != loopEnd || body.offset != 0) {
+            return pos;
+          }
+          if (body.isAccessed) {
+            range.access(body.minOffset);
+            range.access(body.maxOffset);
+          }
+          // LOOP_END reads the same cell as LOOP_START
+          pos = loopEnd;
+        }
+        break;
+      case BfInstruction::LOOP_END:
+      case BfInstruction::END_IF:
+      case BfInstruction::CHECK:
+        break;
+    }
+  }
+  return end;
+}
+
+
+/*!
+ * @brief Append the instructions with CHECK instructions
+ * @param [in,out] checkedCode  Destination Brainfuck IR code
+ * @param [in]     irCode       Source Brainfuck IR code
+ * @param [in]     pos          Position of the first instruction
+ * @param [in]     end          Position of the end of the instructions
+ * @param [in]     isLoopBody   true if the instructions are the loop body,
+ *                              whose LOOP_END reads the last cell
+ */
+void
+BfIROptimizer::genCheckedCode(BfIR &checkedCode, const BfIR &irCode, BfIR::size_type pos, BfIR::size_type end, bool isLoopBody)
+{
+  for (;;) {
+    AccessRange range;
+    BfIR::size_type stop = scanAccessRange(irCode, pos, end, range);
+    if (stop == end && isLoopBody) {
+      range.access(0);
+    }
+    if (range.isAccessed) {
+      BfInstruction::Command cmd;
+      cmd.type = BfInstruction::CHECK;
+      cmd.value1 = range.minOffset;
+      cmd.value2 = range.maxOffset;
+      checkedCode.push_back(cmd);
+    }
+    checkedCode.insert(checkedCode.end(), irCode.begin() + static_cast<std::ptrdiff_t>(pos), irCode.begin() + static_cast<std::ptrdiff_t>(stop));
+    if (stop == end) {
+      return;
+    }
+    checkedCode.push_back(irCode[stop]);
+    if (irCode[stop].type == BfInstruction::LOOP_START || irCode[stop].type == BfInstruction::IF) {
+      // END_IF doesn't read the cell
+      BfIR::size_type loopEnd = static_cast<BfIR::size_type>(irCode[stop].value1);
+      genCheckedCode(checkedCode, irCode, stop + 1, loopEnd, irCode[stop].type == BfInstruction::LOOP_START);
+      checkedCode.push_back(irCode[loopEnd]);
+      pos = loopEnd + 1;
+    } else {
+      pos = stop + 1;
+    }
+  }
+}
+
+
+/*!
+ * @brief Start recording the changes, so that they can be rolled back
+ */
+void
+BfIROptimizer::PrefixState::setCheckpoint(void)
+{
+  undoLog.clear();
+  hasCheckpoint = true;
+  checkpointPos = pos;
+  checkpointOutputSize = output.size();
+}
+
+
+/*!
+ * @brief Accept the changes since the checkpoint
+ */
+void
+BfIROptimizer::PrefixState::clearCheckpoint(void)
+{
+  undoLog.clear();
+  hasCheckpoint = false;
+}
+
+
+/*!
+ * @brief Restore the state at the checkpoint
+ */
+void
+BfIROptimizer::PrefixState::rollback(void)
+{
+  for (std::vector<std::pair<std::size_t, int> >::reverse_iterator itr = undoLog.rbegin(); itr != undoLog.rend(); itr++) {
+    tape[itr->first] = itr->second;
+  }
+  pos = checkpointPos;
+  output.resize(checkpointOutputSize);
+  clearCheckpoint();
+}
+
+
+/*!
+ * @brief Shift the offsets as the pointer moves
+ * @param [in] offset  Amount of the pointer movement
+ */
+void
+BfIROptimizer::KnownCells::move(int offset)
+{
+  std::map<int, int> movedValues;
+  for (std::map<int, int>::const_iterator itr = values.begin(); itr != values.end(); itr++) {
+    movedValues.insert(movedValues.end(), std::make_pair(itr->first - offset, itr->second));
+  }
+  values.swap(movedValues);
+  std::set<int> movedUnknowns;
+  for (std::set<int>::const_iterator itr = unknowns.begin(); itr != unknowns.end(); itr++) {
+    movedUnknowns.insert(movedUnknowns.end(), *itr - offset);
+  }
+  unknowns.swap(movedUnknowns);
+  pos += offset;
+}
+
+
+/*!
+ * @brief Convert the instruction at offset zero into the simple one
+ * @param [in,out] cmd  Instruction
+ */
+void
+BfIROptimizer::normalizeOperationAt(BfInstruction::Command &cmd)
+{
+  if (cmd.value1 != 0) {
+    return;
+  }
+  switch (cmd.type) {
+    case BfInstruction::INC_AT:
+      cmd.type = BfInstruction::INC;
+      break;
+    case BfInstruction::DEC_AT:
+      cmd.type = BfInstruction::DEC;
+      break;
+    case BfInstruction::ADD_AT:
+      cmd.type = BfInstruction::ADD;
+      cmd.value1 = cmd.value2;
+      cmd.value2 = 0;
+      break;
+    case BfInstruction::SUB_AT:
+      cmd.type = BfInstruction::SUB;
+      cmd.value1 = cmd.value2;
+      cmd.value2 = 0;
+      break;
+    case BfInstruction::ASSIGN_AT:
+      cmd.type = cmd.value2 == 0 ? BfInstruction::ASSIGN_ZERO : BfInstruction::ASSIGN;
+      cmd.value1 = cmd.value2;
+      cmd.value2 = 0;
+      break;
+    case BfInstruction::NEXT:
+    case BfInstruction::PREV:
+    case BfInstruction::NEXT_N:
+    case BfInstruction::PREV_N:
+    case BfInstruction::INC:
+    case BfInstruction::DEC:
+    case BfInstruction::ADD:
+    case BfInstruction::SUB:
+    case BfInstruction::PUTCHAR:
+    case BfInstruction::GETCHAR:
+    case BfInstruction::LOOP_START:
+    case BfInstruction::LOOP_END:
+    case BfInstruction::ASSIGN_ZERO:
+    case BfInstruction::ASSIGN:
+    case BfInstruction::SEARCH_ZERO:
+    case BfInstruction::ADD_VAR:
+    case BfInstruction::SUB_VAR:
+    case BfInstruction::CMUL_VAR:
+    case BfInstruction::MULTI_CMUL_VAR:
+    case BfInstruction::CMUL_TARGET:
+    case BfInstruction::INF_LOOP:
+    case BfInstruction::CHECK:
+    case BfInstruction::PUTS:
+    case BfInstruction::IF:
+    case BfInstruction::END_IF:
+      break;
+  }
+}
+
+
+}  // namespace bf
+
+
+
+
+/*!
+ * @brief Check whether the value fits in 8-bit cell without wrap-around
+ * @param [in] value  Value of the cell
+ * @return true if the value is in [0, 255], otherwise false
+ */
+static inline bool
+isCellValue(long value)
+{
+  return 0 <= value && value <= 255;
+}
+
+
+/*!
+ * @brief Check whether the value is small enough to be tracked without
+ *        overflow
+ * @param [in] value  Value of the cell
+ * @return true if the value is tracked, otherwise false
+ */
+static inline bool
+isTrackedValue(long value)
+{
+  return -0x1000000L <= value && value <= 0x1000000L;
+}
+
+
+/*!
+ * @brief Check whether the factors of the multiply loop are small enough to
+ *        be unrolled with the known value of the cell
+ * @param [in] irCode  Brainfuck IR code
+ * @param [in] cmd     ADD_VAR, SUB_VAR, CMUL_VAR or MULTI_CMUL_VAR
+ * @param [in] first   Position of the first target
+ * @param [in] last    Position of the last target
+ * @return true if all factors are in [-65535, 65535], otherwise false
+ */
+static inline bool
+hasSmallFactors(const bf::BfIR &irCode, const bf::BfInstruction::Command &cmd, bf::BfIR::size_type first, bf::BfIR::size_type last)
+{
+  if (cmd.type == bf::BfInstruction::ADD_VAR || cmd.type == bf::BfInstruction::SUB_VAR) {
+    return true;
+  }
+  for (bf::BfIR::size_type i = first; i <= last; i++) {
+    if (irCode[i].value2 < -65535 || irCode[i].value2 > 65535) {
+      return false;
+    }
+  }
+  return true;
+}
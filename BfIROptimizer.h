@@ -0,0 +1,246 @@
+/*!
+ * @file BfIROptimizer.h
+ * @brief Optimization passes for Brainfuck-IR
+ * @author koturn
+ */
+#ifndef BF_IR_OPTIMIZER_H
+#define BF_IR_OPTIMIZER_H
+
+#include <cstddef>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+#include "BfIRCompiler.h"
+
+
+namespace bf {
+
+
+/*!
+ * @brief Optimization passes for Brainfuck-IR
+ */
+class BfIROptimizer {
+public:
+  static const unsigned long PREFIX_STEP_BUDGET = 1UL << 16;
+
+  static void sinkPointerMotion(BfIR &irCode);
+  static void evaluatePrefix(BfIR &irCode, std::size_t memorySize);
+  static void propagateKnownValues(BfIR &irCode, std::size_t memorySize);
+  static void coalesceOutput(BfIR &irCode, BfStringPool &strings);
+  static void insertBoundsChecks(BfIR &irCode);
+  static void relinkLoops(BfIR &irCode);
+
+private:
+  /*!
+   * @brief Range of the cells which are accessed by the instructions
+   *
+   * Offsets are relative to the pointer at the start of the instructions.
+   */
+  struct AccessRange {
+    int offset;
+    int minOffset;
+    int maxOffset;
+    bool isAccessed;
+
+    AccessRange(void) :
+      offset(0),
+      minOffset(0),
+      maxOffset(0),
+      isAccessed(false)
+    {}
+    inline void access(int at);
+  };
+
+  /*!
+   * @brief State of the tape and the output which is computed at compile time
+   *
+   * Cells are held as int, and the evaluation stops before a cell goes out
+   * of the range of 8-bit cell, so that the state doesn't depend on the
+   * width of the cell.
+   * While a checkpoint is set, the old values of the accessed cells are
+   * recorded, so that the state can be rolled back without copying the
+   * whole tape.
+   */
+  struct PrefixState {
+    std::vector<int> tape;
+    long pos;
+    std::string output;
+    std::vector<std::pair<std::size_t, int> > undoLog;
+    bool hasCheckpoint;
+    long checkpointPos;
+    std::string::size_type checkpointOutputSize;
+
+    PrefixState(void) :
+      tape(),
+      pos(0),
+      output(),
+      undoLog(),
+      hasCheckpoint(false),
+      checkpointPos(0),
+      checkpointOutputSize(0)
+    {}
+    inline int *getCell(int offset, std::size_t memorySize);
+    void setCheckpoint(void);
+    void clearCheckpoint(void);
+    void rollback(void);
+  };
+
+  /*!
+   * @brief Values of the cells which are known at compile time
+   *
+   * Offsets are relative to the current pointer, and values are held as int
+   * without wrap-around, so that they don't depend on the width of the cell.
+   * While isZeroFilled is true, the position of the pointer is known and the
+   * cells in the tape which are not recorded are zero.
+   */
+  struct KnownCells {
+    std::map<int, int> values;
+    std::set<int> unknowns;
+    bool isZeroFilled;
+    long pos;
+    std::size_t memorySize;
+
+    explicit KnownCells(std::size_t memorySize) :
+      values(),
+      unknowns(),
+      isZeroFilled(memorySize != 0),
+      pos(0),
+      memorySize(memorySize)
+    {}
+    inline bool get(int offset, int &value) const;
+    inline void set(int offset, int value);
+    inline void forget(int offset);
+    inline void forgetAll(void);
+    void move(int offset);
+  };
+
+  static BfIR::size_type runPrefix(const BfIR &irCode, std::size_t memorySize, PrefixState &state);
+  static bool stepPrefix(const BfIR &irCode, BfIR::size_type &pos, std::size_t memorySize, PrefixState &state, unsigned long &steps);
+  static void genPrefixState(BfIR &irCode, const PrefixState &state);
+  static void genKnownValueCode(BfIR &optCode, const BfIR &irCode, BfIR::size_type pos, BfIR::size_type end, KnownCells &cells);
+  static void genAddAtKnown(BfIR &optCode, KnownCells &cells, int offset, long delta);
+  static bool collectWrittenCells(const BfIR &irCode, BfIR::size_type pos, BfIR::size_type end, std::set<int> &written);
+  static void genAssignAt(BfIR &irCode, int offset, int value);
+  static void genAddAt(BfIR &irCode, int offset, long delta);
+  static void genKnownCells(BfIR &irCode, BfStringPool &strings, std::map<int, int> &knownCells, std::string &pendingOutput, int scratchOffset);
+  static void genPuts(BfIR &irCode, BfStringPool &strings, std::string &pendingOutput, int scratchOffset);
+  static BfIR::size_type scanAccessRange(const BfIR &irCode, BfIR::size_type pos, BfIR::size_type end, AccessRange &range);
+  static void genCheckedCode(BfIR &checkedCode, const BfIR &irCode, BfIR::size_type pos, BfIR::size_type end, bool isLoopBody);
+  static void genPointerMotion(BfIR &irCode, int offset);
+  static void normalizeOperationAt(BfInstruction::Command &cmd);
+};
+
+
+/*!
+ * @brief Record the access to the cell
+ * @param [in] at  Offset of the cell from the current pointer
+ */
+inline void
+BfIROptimizer::AccessRange::access(int at)
+{
+  at += offset;
+  if (!isAccessed) {
+    minOffset = maxOffset = at;
+    isAccessed = true;
+  } else if (at < minOffset) {
+    minOffset = at;
+  } else if (at > maxOffset) {
+    maxOffset = at;
+  }
+}
+
+
+/*!
+ * @brief Get the cell at the offset from the pointer
+ *
+ * The tape grows on demand up to memorySize cells.
+ * The cell may be written, so its value is recorded in the undo log.
+ * @param [in] offset      Offset from the pointer
+ * @param [in] memorySize  The number of the cells of the tape at runtime
+ * @return Pointer to the cell, or nullptr if the cell is out of the tape
+ */
+inline int *
+BfIROptimizer::PrefixState::getCell(int offset, std::size_t memorySize)
+{
+  long at = pos + offset;
+  if (at < 0 || static_cast<unsigned long>(at) >= memorySize) {
+    return nullptr;
+  }
+  std::size_t index = static_cast<std::size_t>(at);
+  if (index >= tape.size()) {
+    tape.resize(index + 1, 0);
+  }
+  if (hasCheckpoint) {
+    undoLog.push_back(std::make_pair(index, tape[index]));
+  }
+  return &tape[index];
+}
+
+
+/*!
+ * @brief Get the value of the cell if it is known
+ * @param [in]  offset  Offset from the pointer
+ * @param [out] value   Value of the cell
+ * @return true if the value is known, otherwise false
+ */
+inline bool
+BfIROptimizer::KnownCells::get(int offset, int &value) const
+{
+  std::map<int, int>::const_iterator itr = values.find(offset);
+  if (itr != values.end()) {
+    value = itr->second;
+    return true;
+  }
+  long at = pos + offset;
+  if (!isZeroFilled || unknowns.find(offset) != unknowns.end()
+      || at < 0 || static_cast<unsigned long>(at) >= memorySize) {
+    return false;
+  }
+  value = 0;
+  return true;
+}
+
+
+/*!
+ * @brief Record the value of the cell
+ * @param [in] offset  Offset from the pointer
+ * @param [in] value   Value of the cell
+ */
+inline void
+BfIROptimizer::KnownCells::set(int offset, int value)
+{
+  values[offset] = value;
+  unknowns.erase(offset);
+}
+
+
+/*!
+ * @brief Forget the value of the cell
+ * @param [in] offset  Offset from the pointer
+ */
+inline void
+BfIROptimizer::KnownCells::forget(int offset)
+{
+  values.erase(offset);
+  if (isZeroFilled) {
+    unknowns.insert(offset);
+  }
+}
+
+
+/*!
+ * @brief Forget the values of all cells
+ */
+inline void
+BfIROptimizer::KnownCells::forgetAll(void)
+{
+  values.clear();
+  unknowns.clear();
+  isZeroFilled = false;
+}
+
+
+}  // namespace bf
+#endif  // BF_IR_OPTIMIZER_H
@@ -3,7 +3,10 @@
  * @brief Brainfuck JIT-compiler
  * @author koturn
  */
+#include <algorithm>
+#include <cstring>
 #include <stack>
+#include <string>
 #include "BfJitCompiler.h"
 
 
@@ -15,66 +18,107 @@ typedef enum {
 inline static std::string
 toStr(int labelNo, Direction dir);
 
+static const char FLUSH_LABEL[] = "flush";
+static const char EXIT_LABEL[] = "exit";
+static const char OVERFLOW_LABEL[] = "overflow";
+
 
 namespace bf {
 
 
 /*!
  * @brief Compile brainfuck IR code with Xbyak JIT-compile
+ *
+ * Generated code takes the flush function, getchar, the memory and the
+ * pointer to store its frame, and returns 0, or 1 if CHECK finds that the
+ * pointer is out of the tape.
+ * Output is appended to the buffer on the stack frame, which is passed to
+ * the flush function when it is full, before GETCHAR and at exit.
+ * The end of the output is also stored in the frame, so that the fault
+ * handler can write the buffered output with getBufferedOutput().
  */
 void
 BfJitCompiler::compile(void)
 {
 #ifdef XBYAK32
-  const Xbyak::Reg32 &pPutchar(esi);
+  const Xbyak::Reg32 &pFlush(esi);
   const Xbyak::Reg32 &pGetchar(edi);
   const Xbyak::Reg32 &stack(ebp);
-  const Xbyak::Address cur = dword[stack];
+  const Xbyak::Reg32 &outPtr(ebx);
+  const Xbyak::Reg32 &sp(esp);
+  const Xbyak::Reg32 &tmp(eax);
+  const Xbyak::Address cur = getCellFrame()[stack];
   push(ebp);  // stack
   push(esi);
   push(edi);
-  const int P_ = 4 * 3;
-  mov(pPutchar, ptr[esp + P_ + 4]);  // putchar
+  push(ebx);
+  const int P_ = 4 * 4;
+  mov(pFlush, ptr[esp + P_ + 4]);  // flush
   mov(pGetchar, ptr[esp + P_ + 8]);  // getchar
   mov(stack, ptr[esp + P_ + 12]);  // stack
+  mov(tmp, ptr[esp + P_ + 16]);  // frame
+  const Xbyak::Reg32 &pFrame(tmp);
+  const int frameSize = OUTPUT_BUFFER_SIZE + 8;
 #elif defined(XBYAK64_WIN)
-  const Xbyak::Reg64 &pPutchar(rsi);
+  const Xbyak::Reg64 &pFlush(rsi);
   const Xbyak::Reg64 &pGetchar(rdi);
   const Xbyak::Reg64 &stack(rbp);  // stack
-  const Xbyak::Address cur = dword[stack];
+  const Xbyak::Reg64 &outPtr(rbx);
+  const Xbyak::Reg64 &sp(rsp);
+  const Xbyak::Reg64 &tmp(rax);
+  const Xbyak::Address cur = getCellFrame()[stack];
   push(rsi);
   push(rdi);
   push(rbp);
-  mov(pPutchar, rcx);  // putchar
+  push(rbx);
+  mov(pFlush, rcx);  // flush
   mov(pGetchar, rdx);  // getchar
   mov(stack, r8);  // stack
+  const Xbyak::Reg64 &pFrame(r9);
+  // Keep rsp 16-byte aligned
+  const int frameSize = OUTPUT_BUFFER_SIZE + 24;
 #else
-  const Xbyak::Reg64& pPutchar(rbx);
+  const Xbyak::Reg64& pFlush(rbx);
   const Xbyak::Reg64& pGetchar(rbp);
   const Xbyak::Reg64& stack(r12);  // stack
-  const Xbyak::Address cur = dword[stack];
+  const Xbyak::Reg64& outPtr(r13);
+  const Xbyak::Reg64& sp(rsp);
+  const Xbyak::Reg64& tmp(rax);
+  const Xbyak::Address cur = getCellFrame()[stack];
   push(rbx);
   push(rbp);
   push(r12);
-  mov(pPutchar, rdi);  // putchar
+  push(r13);
+  mov(pFlush, rdi);  // flush
   mov(pGetchar, rsi);  // getchar
   mov(stack, rdx);  // stack
+  const Xbyak::Reg64 &pFrame(rcx);
+  // Keep rsp 16-byte aligned
+  const int frameSize = OUTPUT_BUFFER_SIZE + 24;
 #endif  // XBYAK32
+  // Output buffer is placed at the bottom of the stack frame, and the start
+  // of the tape for CHECK and the end of the output are kept just above it
+  sub(sp, frameSize);
+  mov(ptr[pFrame], sp);
+  mov(outPtr, sp);
+  mov(ptr[sp + OUTPUT_BUFFER_SIZE], stack);
+  mov(ptr[sp + OUTPUT_POINTER_OFFSET], outPtr);
   int labelNo = 0;
   std::stack<int> keepLabelNo;
+  const BfIR &irCode = irModule.getCode();
   for (BfIR::const_iterator cmd = irCode.begin(), end = irCode.end(); cmd != end; cmd++) {
     switch (cmd->type) {
       case BfInstruction::NEXT:
-        add(stack, 4);
+        add(stack, cellSize);
         break;
       case BfInstruction::PREV:
-        sub(stack, 4);
+        sub(stack, cellSize);
         break;
       case BfInstruction::NEXT_N:
-        add(stack, 4 * cmd->value1);
+        add(stack, cellSize * cmd->value1);
         break;
       case BfInstruction::PREV_N:
-        sub(stack, 4 * cmd->value1);
+        sub(stack, cellSize * cmd->value1);
         break;
       case BfInstruction::INC:
         inc(cur);
@@ -83,61 +127,53 @@ BfJitCompiler::compile(void)
         dec(cur);
         break;
       case BfInstruction::ADD:
-        add(cur, cmd->value1);
+        add(cur, toCellImm(cmd->value1));
         break;
       case BfInstruction::SUB:
-        sub(cur, cmd->value1);
+        sub(cur, toCellImm(cmd->value1));
         break;
       case BfInstruction::INC_AT:
-        add(stack, 4 * cmd->value1);
-        inc(cur);
-        sub(stack, 4 * cmd->value1);
+        inc(getCellFrame()[stack + cellSize * cmd->value1]);
         break;
       case BfInstruction::DEC_AT:
-        add(stack, 4 * cmd->value1);
-        dec(cur);
-        sub(stack, 4 * cmd->value1);
+        dec(getCellFrame()[stack + cellSize * cmd->value1]);
         break;
       case BfInstruction::ADD_AT:
-        add(stack, 4 * cmd->value1);
-        add(cur, cmd->value2);
-        sub(stack, 4 * cmd->value1);
+        add(getCellFrame()[stack + cellSize * cmd->value1], toCellImm(cmd->value2));
         break;
       case BfInstruction::SUB_AT:
-        add(stack, 4 * cmd->value1);
-        sub(cur, cmd->value2);
-        sub(stack, 4 * cmd->value1);
+        sub(getCellFrame()[stack + cellSize * cmd->value1], toCellImm(cmd->value2));
         break;
       case BfInstruction::PUTCHAR:
-#ifdef XBYAK32
-        push(cur);
-        call(pPutchar);
-        pop(eax);
-#elif defined(XBYAK64_WIN)
-        mov(rcx, cur);
-        sub(rsp, 32);
-        call(pPutchar);
-        add(rsp, 32);
-#else
-        mov(rdi, cur);
-        call(pPutchar);
-#endif  // XBYAK32
+        genLoadCell(eax, getCellFrame()[stack + cellSize * cmd->value1]);
+        mov(byte[outPtr], al);
+        inc(outPtr);
+        mov(ptr[sp + OUTPUT_POINTER_OFFSET], outPtr);
+        lea(tmp, ptr[sp + OUTPUT_BUFFER_SIZE]);
+        cmp(outPtr, tmp);
+        jne(toStr(labelNo, F));
+        call(FLUSH_LABEL);
+        L(toStr(labelNo++, F));
         break;
       case BfInstruction::GETCHAR:
+        // Flush the output before waiting for the input
+        cmp(outPtr, sp);
+        je(toStr(labelNo, F));
+        call(FLUSH_LABEL);
+        L(toStr(labelNo++, F));
 #if defined(XBYAK32) || defined(XBYAK64_GCC)
         call(pGetchar);
-        mov(cur, eax);
+        mov(getCellFrame()[stack + cellSize * cmd->value1], toCellReg(eax));
 #elif defined(XBYAK64_WIN)
         sub(rsp, 32);
         call(pGetchar);
         add(rsp, 32);
-        mov(cur, rax);
+        mov(getCellFrame()[stack + cellSize * cmd->value1], toCellReg(eax));
 #endif  // defined(XBYAK32) || defined(XBYAK64_GCC)
         break;
       case BfInstruction::LOOP_START:
         L(toStr(labelNo, B));
-        mov(eax, cur);
-        test(eax, eax);
+        cmp(cur, 0);
         jz(toStr(labelNo, F), Xbyak::CodeGenerator::T_NEAR);
         keepLabelNo.push(labelNo++);
         break;
@@ -153,22 +189,25 @@ BfJitCompiler::compile(void)
         mov(cur, 0);
         break;
       case BfInstruction::ASSIGN:
-        mov(cur, cmd->value1);
+        mov(cur, toCellImm(cmd->value1));
         break;
       case BfInstruction::ASSIGN_AT:
-        add(stack, 4 * cmd->value1);
-        mov(cur, cmd->value2);
-        sub(stack, 4 * cmd->value1);
+        mov(getCellFrame()[stack + cellSize * cmd->value1], toCellImm(cmd->value2));
         break;
       case BfInstruction::SEARCH_ZERO:
+#ifdef XBYAK64
+        if (genSearchZero(stack, cmd->value1, labelNo)) {
+          labelNo++;
+          break;
+        }
+#endif  // XBYAK64
         // LOOP_START
         L(toStr(labelNo, B));
-        mov(eax, cur);
-        test(eax, eax);
+        cmp(cur, 0);
         jz(toStr(labelNo, F), Xbyak::CodeGenerator::T_NEAR);
         keepLabelNo.push(labelNo++);
         // NEXT_N / PREV_N
-        add(stack, 4 * cmd->value1);
+        add(stack, cellSize * cmd->value1);
         // LOOP_END
         {
           int no = keepLabelNo.top();
@@ -178,43 +217,37 @@ BfJitCompiler::compile(void)
         }
         break;
       case BfInstruction::ADD_VAR:
-        // LOOP_START
-        L(toStr(labelNo, B));
-        mov(eax, cur);
-        test(eax, eax);
-        jz(toStr(labelNo, F), Xbyak::CodeGenerator::T_NEAR);
-        keepLabelNo.push(labelNo++);
-        // SUB
-        dec(cur);
-        // PTR_ADD
-        add(stack, 4 * cmd->value1);
-        // ADD
-        inc(cur);
-        // PTR_SUB
-        sub(stack, 4 * cmd->value1);
-        // LOOP_END
-        {
-          int no = keepLabelNo.top();
-          keepLabelNo.pop();
-          jmp(toStr(no, B));
-          L(toStr(no, F));
-        }
+        genLoadCell(eax, cur);
+        genCmul(getCellFrame()[stack + cellSize * cmd->value1], 1);
+        mov(cur, 0);
         break;
       case BfInstruction::SUB_VAR:
+        genLoadCell(eax, cur);
+        genCmul(getCellFrame()[stack + cellSize * cmd->value1], -1);
+        mov(cur, 0);
+        break;
+      case BfInstruction::CMUL_VAR:
+        genLoadCell(eax, cur);
+        genCmul(getCellFrame()[stack + cellSize * cmd->value1], cmd->value2);
+        mov(cur, 0);
+        break;
+      case BfInstruction::MULTI_CMUL_VAR:
+        genLoadCell(eax, cur);
+        for (BfIR::const_iterator last = cmd + cmd->value1; cmd != last;) {
+          cmd++;
+          genCmul(getCellFrame()[stack + cellSize * cmd->value1], cmd->value2);
+        }
+        mov(cur, 0);
+        break;
+      case BfInstruction::CMUL_TARGET:
+        // Always consumed by MULTI_CMUL_VAR
+        break;
+      case BfInstruction::INF_LOOP:
         // LOOP_START
         L(toStr(labelNo, B));
-        mov(eax, cur);
-        test(eax, eax);
+        cmp(cur, 0);
         jz(toStr(labelNo, F), Xbyak::CodeGenerator::T_NEAR);
         keepLabelNo.push(labelNo++);
-        // SUB
-        dec(cur);
-        // PTR_ADD
-        add(stack, 4 * cmd->value1);
-        // SUB
-        dec(cur);
-        // PTR_SUB
-        sub(stack, 4 *cmd->value1);
         // LOOP_END
         {
           int no = keepLabelNo.top();
@@ -223,61 +256,448 @@ BfJitCompiler::compile(void)
           L(toStr(no, F));
         }
         break;
-      case BfInstruction::CMUL_VAR:
-        // LOOP_START
-        L(toStr(labelNo, B));
-        mov(eax, cur);
-        test(eax, eax);
-        jz(toStr(labelNo, F), Xbyak::CodeGenerator::T_NEAR);
-        keepLabelNo.push(labelNo++);
-        // SUB
-        dec(cur);
-        // PTR_ADD
-        add(stack, 4 * cmd->value1);
-        // ADD
-        add(cur, cmd->value2);
-        // PTR_SUB
-        sub(stack, 4 * cmd->value1);
-        // LOOP_END
+      case BfInstruction::CHECK:
         {
-          int no = keepLabelNo.top();
-          keepLabelNo.pop();
-          jmp(toStr(no, B));
-          L(toStr(no, F));
+          // Both ends are tested with one unsigned comparison of the offset
+          // of the lowest accessed cell
+          std::size_t width = static_cast<std::size_t>(cmd->value2 - cmd->value1);
+          if (width >= memorySize) {
+            jmp(OVERFLOW_LABEL, Xbyak::CodeGenerator::T_NEAR);
+            break;
+          }
+          std::size_t limit = (memorySize - 1 - width) * static_cast<std::size_t>(cellSize);
+          mov(tmp, stack);
+          sub(tmp, ptr[sp + OUTPUT_BUFFER_SIZE]);
+          if (cmd->value1 != 0) {
+            add(tmp, cellSize * cmd->value1);
+          }
+#ifdef XBYAK64
+          if (limit > 0x7fffffff) {
+            mov(rcx, static_cast<Xbyak::uint64>(limit));
+            cmp(tmp, rcx);
+          } else {
+            cmp(tmp, static_cast<Xbyak::uint32>(limit));
+          }
+#else
+          cmp(tmp, static_cast<Xbyak::uint32>(limit));
+#endif  // XBYAK64
+          ja(OVERFLOW_LABEL, Xbyak::CodeGenerator::T_NEAR);
         }
         break;
-      case BfInstruction::INF_LOOP:
-        // LOOP_START
-        L(toStr(labelNo, B));
-        mov(eax, cur);
-        test(eax, eax);
+      case BfInstruction::IF:
+        cmp(cur, 0);
         jz(toStr(labelNo, F), Xbyak::CodeGenerator::T_NEAR);
         keepLabelNo.push(labelNo++);
-        // LOOP_END
+        break;
+      case BfInstruction::END_IF:
+        L(toStr(keepLabelNo.top(), F));
+        keepLabelNo.pop();
+        break;
+      case BfInstruction::PUTS:
         {
-          int no = keepLabelNo.top();
-          keepLabelNo.pop();
-          jmp(toStr(no, B));
-          L(toStr(no, F));
+          // The bytes are stored as immediates chunk by chunk, and the buffer
+          // is flushed in advance if the chunk doesn't fit in it
+          const std::string &str = irModule.getStrings()[static_cast<BfStringPool::size_type>(cmd->value1)];
+          for (std::string::size_type pos = 0; pos < str.size(); pos += PUTS_CHUNK_SIZE) {
+            int n = static_cast<int>(std::min(str.size() - pos, static_cast<std::string::size_type>(PUTS_CHUNK_SIZE)));
+            lea(tmp, ptr[sp + (OUTPUT_BUFFER_SIZE - n)]);
+            cmp(outPtr, tmp);
+            jb(toStr(labelNo, F));
+            call(FLUSH_LABEL);
+            L(toStr(labelNo++, F));
+            int i = 0;
+            for (; i + 4 <= n; i += 4) {
+              Xbyak::uint32 imm = 0;
+              for (int j = 3; j >= 0; j--) {
+                imm = (imm << 8) | static_cast<unsigned char>(str[pos + static_cast<std::string::size_type>(i + j)]);
+              }
+              mov(dword[outPtr + i], imm);
+            }
+            for (; i < n; i++) {
+              mov(byte[outPtr + i], static_cast<unsigned char>(str[pos + static_cast<std::string::size_type>(i)]));
+            }
+            add(outPtr, n);
+            mov(ptr[sp + OUTPUT_POINTER_OFFSET], outPtr);
+          }
         }
         break;
     }
   }
+  cmp(outPtr, sp);
+  je(toStr(labelNo, F));
+  call(FLUSH_LABEL);
+  L(toStr(labelNo++, F));
+  xor_(eax, eax);
+  L(EXIT_LABEL);
+  add(sp, frameSize);
 #ifdef XBYAK32
+  pop(ebx);
   pop(edi);
   pop(esi);
   pop(ebp);
 #elif defined(XBYAK64_WIN)
+  pop(rbx);
   pop(rbp);
   pop(rdi);
   pop(rsi);
 #else
+  pop(r13);
   pop(r12);
   pop(rbp);
   pop(rbx);
 #endif  // XBYAK32
   ret();
+
+  // Overflow stub: flush the output which is written before the error
+  L(OVERFLOW_LABEL);
+  cmp(outPtr, sp);
+  je(toStr(labelNo, F));
+  call(FLUSH_LABEL);
+  L(toStr(labelNo++, F));
+  mov(eax, 1);
+  jmp(EXIT_LABEL, Xbyak::CodeGenerator::T_NEAR);
+
+  // Flush stub: pass the buffered bytes to the flush function and rewind the
+  // output pointer; the output buffer is just above the return address
+  L(FLUSH_LABEL);
+#ifdef XBYAK32
+  lea(eax, ptr[esp + 4]);
+  mov(ecx, outPtr);
+  sub(ecx, eax);
+  push(ecx);
+  push(eax);
+  call(pFlush);
+  add(esp, 8);
+  lea(outPtr, ptr[esp + 4]);
+  mov(ptr[esp + 4 + OUTPUT_POINTER_OFFSET], outPtr);
+#elif defined(XBYAK64_WIN)
+  lea(rcx, ptr[rsp + 8]);
+  mov(rdx, outPtr);
+  sub(rdx, rcx);
+  sub(rsp, 40);
+  call(pFlush);
+  add(rsp, 40);
+  lea(outPtr, ptr[rsp + 8]);
+  mov(ptr[rsp + 8 + OUTPUT_POINTER_OFFSET], outPtr);
+#else
+  lea(rdi, ptr[rsp + 8]);
+  mov(rsi, outPtr);
+  sub(rsi, rdi);
+  sub(rsp, 8);
+  call(pFlush);
+  add(rsp, 8);
+  lea(outPtr, ptr[rsp + 8]);
+  mov(ptr[rsp + 8 + OUTPUT_POINTER_OFFSET], outPtr);
+#endif  // XBYAK32
+  ret();
+  // Resolve the addresses of the auto-grown buffer
+  ready();
+}
+
+
+/*!
+ * @brief Estimate the size of the code generated from Brainfuck-IR
+ *
+ * The estimate is the sum of the upper bound of each instruction, so that
+ * the code buffer doesn't have to grow in most cases.
+ * @param [in] irModule  Brainfuck-IR
+ * @return Estimated size in bytes
+ */
+std::size_t
+BfJitCompiler::estimateCodeSize(const BfIRModule &irModule)
+{
+  // Prologue, epilogue and the flush stub
+  std::size_t size = 128;
+  const BfIR &irCode = irModule.getCode();
+  for (BfIR::const_iterator cmd = irCode.begin(), end = irCode.end(); cmd != end; cmd++) {
+    switch (cmd->type) {
+      case BfInstruction::NEXT:
+      case BfInstruction::PREV:
+      case BfInstruction::NEXT_N:
+      case BfInstruction::PREV_N:
+      case BfInstruction::LOOP_END:
+      case BfInstruction::END_IF:
+        size += 8;
+        break;
+      case BfInstruction::INC:
+      case BfInstruction::DEC:
+      case BfInstruction::ADD:
+      case BfInstruction::SUB:
+      case BfInstruction::ASSIGN_ZERO:
+      case BfInstruction::ASSIGN:
+        size += 10;
+        break;
+      case BfInstruction::INC_AT:
+      case BfInstruction::DEC_AT:
+      case BfInstruction::ADD_AT:
+      case BfInstruction::SUB_AT:
+      case BfInstruction::ASSIGN_AT:
+      case BfInstruction::LOOP_START:
+      case BfInstruction::IF:
+        size += 16;
+        break;
+      case BfInstruction::CMUL_TARGET:
+      case BfInstruction::INF_LOOP:
+        size += 24;
+        break;
+      case BfInstruction::PUTCHAR:
+      case BfInstruction::GETCHAR:
+      case BfInstruction::ADD_VAR:
+      case BfInstruction::SUB_VAR:
+      case BfInstruction::CMUL_VAR:
+      case BfInstruction::MULTI_CMUL_VAR:
+      case BfInstruction::CHECK:
+        size += 48;
+        break;
+      case BfInstruction::SEARCH_ZERO:
+        size += 160;
+        break;
+      case BfInstruction::PUTS:
+        {
+          // Flush check per chunk, and one dword store per four bytes
+          std::size_t length = irModule.getStrings()[static_cast<BfStringPool::size_type>(cmd->value1)].size();
+          size += (length / PUTS_CHUNK_SIZE + 1) * 48 + length * 3;
+        }
+        break;
+    }
+  }
+  return size;
+}
+
+
+/*!
+ * @brief Get the output which is buffered in the frame of the running code
+ *
+ * This function is async-signal-safe, so that it can be called from the
+ * fault handler.
+ * @param [in]  frame  Frame which the code stored at its entry
+ * @param [out] size   The number of the buffered bytes
+ * @return Head of the buffered output
+ */
+const unsigned char *
+BfJitCompiler::getBufferedOutput(const unsigned char *frame, std::size_t &size)
+{
+  const unsigned char *end;
+  std::memcpy(&end, frame + OUTPUT_POINTER_OFFSET, sizeof(end));
+  size = static_cast<std::size_t>(end - frame);
+  return frame;
+}
+
+
+/*!
+ * @brief Get the address frame which has the width of the cell
+ * @return byte, word or dword
+ */
+const Xbyak::AddressFrame &
+BfJitCompiler::getCellFrame(void) const
+{
+  switch (cellSize) {
+    case 1:
+      return byte;
+    case 2:
+      return word;
+    default:
+      return dword;
+  }
+}
+
+
+/*!
+ * @brief Get the lower part of the register which has the width of the cell
+ * @param [in] reg  32-bit register
+ * @return 8-bit, 16-bit or 32-bit register
+ */
+Xbyak::Reg
+BfJitCompiler::toCellReg(const Xbyak::Reg32 &reg) const
+{
+  switch (cellSize) {
+    case 1:
+      return reg.cvt8();
+    case 2:
+      return reg.cvt16();
+    default:
+      return reg;
+  }
+}
+
+
+/*!
+ * @brief Truncate the immediate value to the width of the cell
+ *
+ * The value is sign-extended, so that Xbyak encodes it in the width of the
+ * cell.
+ * @param [in] value  Immediate value
+ * @return Truncated value
+ */
+int
+BfJitCompiler::toCellImm(int value) const
+{
+  switch (cellSize) {
+    case 1:
+      return static_cast<signed char>(value & 0xff);
+    case 2:
+      return static_cast<short>(value & 0xffff);
+    default:
+      return value;
+  }
+}
+
+
+/*!
+ * @brief Load the cell into the 32-bit register with zero-extension
+ * @param [out] reg   Destination register
+ * @param [in]  cell  Address of the cell
+ */
+void
+BfJitCompiler::genLoadCell(const Xbyak::Reg32 &reg, const Xbyak::Address &cell)
+{
+  if (cellSize == 4) {
+    mov(reg, cell);
+  } else {
+    movzx(reg, cell);
+  }
+}
+
+
+/*!
+ * @brief Generate the code which adds eax multiplied by the factor to the cell
+ *
+ * eax must hold the value of the current cell; it is left unchanged, so that
+ * the code can be repeated for each target of a multiply loop.
+ * @param [in] target  Address of the target cell
+ * @param [in] factor  Constant factor
+ */
+void
+BfJitCompiler::genCmul(const Xbyak::Address &target, int factor)
+{
+  switch (toCellImm(factor)) {
+    case 0:
+      break;
+    case 1:
+      add(target, toCellReg(eax));
+      break;
+    case -1:
+      sub(target, toCellReg(eax));
+      break;
+    default:
+      imul(ecx, eax, factor);
+      add(target, toCellReg(ecx));
+      break;
+  }
+}
+
+
+#ifdef XBYAK64
+/*!
+ * @brief Generate the SIMD code which finds the first zero cell
+ *
+ * The generated code scans aligned blocks with AVX2 or SSE2, which is
+ * selected with CPUID at compile time.
+ * Aligned blocks never cross the page boundary, so that the scan doesn't
+ * fault on the bytes out of the tape.
+ * @param [in] stack    Register which holds the pointer to the current cell
+ * @param [in] step     Stride of the scan
+ * @param [in] labelNo  Label number for the scan loop
+ * @return true if the code is generated, false if the stride is not
+ *         supported by the SIMD scan
+ */
+bool
+BfJitCompiler::genSearchZero(const Xbyak::Reg64 &stack, int step, int labelNo)
+{
+  BfSimd::InstructionSet instructionSet = BfSimd::getInstructionSet();
+  std::size_t size = instructionSet == BfSimd::AVX2 ? 32 : 16;
+  std::size_t stepBytes = static_cast<std::size_t>(step < 0 ? -step : step) * static_cast<std::size_t>(cellSize);
+  if (instructionSet == BfSimd::SCALAR || stepBytes > size || (stepBytes & (stepBytes - 1)) != 0) {
+    return false;
+  }
+  // rax: aligned block, ecx: offset in the block, edx: mask of the first block, r8d: lane mask
+  mov(rax, stack);
+  mov(ecx, eax);
+  and_(ecx, static_cast<Xbyak::uint32>(size - 1));
+  and_(rax, static_cast<Xbyak::uint32>(-static_cast<int>(size)));
+  if (step > 0) {
+    mov(edx, 0xffffffff);
+    shl(edx, cl);
+  } else {
+    mov(edx, 2);
+    shl(edx, cl);
+    dec(edx);
+  }
+  mov(r8d, BfSimd::getLaneMask(stepBytes));
+  and_(ecx, static_cast<Xbyak::uint32>(stepBytes - 1));
+  shl(r8d, cl);
+  and_(edx, r8d);
+  if (instructionSet == BfSimd::AVX2) {
+    vpxor(ymm0, ymm0, ymm0);
+  } else {
+    pxor(xmm0, xmm0);
+  }
+  genZeroMask(instructionSet);
+  and_(ecx, edx);
+  jnz(toStr(labelNo, F));
+  L(toStr(labelNo, B));
+  if (step > 0) {
+    add(rax, static_cast<Xbyak::uint32>(size));
+  } else {
+    sub(rax, static_cast<Xbyak::uint32>(size));
+  }
+  genZeroMask(instructionSet);
+  and_(ecx, r8d);
+  jz(toStr(labelNo, B));
+  L(toStr(labelNo, F));
+  if (step > 0) {
+    bsf(ecx, ecx);
+  } else {
+    bsr(ecx, ecx);
+  }
+  add(rax, rcx);
+  mov(stack, rax);
+  if (instructionSet == BfSimd::AVX2) {
+    vzeroupper();
+  }
+  return true;
+}
+
+
+/*!
+ * @brief Generate the code which compares the aligned block at rax with zero
+ *
+ * The byte mask of the zero cells is stored into ecx.
+ * @param [in] instructionSet  Instruction set to use
+ */
+void
+BfJitCompiler::genZeroMask(BfSimd::InstructionSet instructionSet)
+{
+  if (instructionSet == BfSimd::AVX2) {
+    switch (cellSize) {
+      case 1:
+        vpcmpeqb(ymm1, ymm0, ptr[rax]);
+        break;
+      case 2:
+        vpcmpeqw(ymm1, ymm0, ptr[rax]);
+        break;
+      default:
+        vpcmpeqd(ymm1, ymm0, ptr[rax]);
+        break;
+    }
+    vpmovmskb(ecx, ymm1);
+  } else {
+    movdqa(xmm1, ptr[rax]);
+    switch (cellSize) {
+      case 1:
+        pcmpeqb(xmm1, xmm0);
+        break;
+      case 2:
+        pcmpeqw(xmm1, xmm0);
+        break;
+      default:
+        pcmpeqd(xmm1, xmm0);
+        break;
+    }
+    pmovmskb(ecx, xmm1);
+  }
 }
+#endif  // XBYAK64
 
 
 }  // namespace bf
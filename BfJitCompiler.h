@@ -10,6 +10,7 @@
 #ifdef USE_XBYAK
 #include <xbyak/xbyak.h>
 #include "BfIRCompiler.h"
+#include "BfSimd.h"
 
 
 namespace bf {
@@ -22,17 +23,64 @@ class BfJitCompiler :
   public Xbyak::CodeGenerator
 {
 private:
-  BfIR irCode;
+  static const int OUTPUT_BUFFER_SIZE = 1024;
+  static const int PUTS_CHUNK_SIZE = 256;
+  //! Offset of the end of the output in the frame
+  static const int OUTPUT_POINTER_OFFSET = OUTPUT_BUFFER_SIZE + static_cast<int>(sizeof(void *));
+
+  BfIRModule irModule;
+  int cellSize;
+  std::size_t memorySize;
+
+  const Xbyak::AddressFrame &getCellFrame(void) const;
+  Xbyak::Reg toCellReg(const Xbyak::Reg32 &reg) const;
+  int toCellImm(int value) const;
+  void genLoadCell(const Xbyak::Reg32 &reg, const Xbyak::Address &cell);
+  void genCmul(const Xbyak::Address &target, int factor);
+#ifdef XBYAK64
+  bool genSearchZero(const Xbyak::Reg64 &stack, int step, int labelNo);
+  void genZeroMask(BfSimd::InstructionSet instructionSet);
+#endif  // XBYAK64
 public:
-  static const std::size_t DEFAULT_GENERATOR_SIZE = 100000;
+  static const std::size_t DEFAULT_GENERATOR_SIZE = 4096;
+  static const int DEFAULT_CELL_SIZE = 1;
+  static const std::size_t DEFAULT_MEMORY_SIZE = 65536;
+  /*!
+   * @brief Constructor
+   *
+   * The code buffer grows automatically, so size is only the initial
+   * capacity.
+   * @param [in] size  Initial size of the code buffer
+   */
   BfJitCompiler(std::size_t size=DEFAULT_GENERATOR_SIZE) :
-    CodeGenerator(size) {}
-  BfJitCompiler(BfIR &irCode, std::size_t size=DEFAULT_GENERATOR_SIZE) :
-    CodeGenerator(size),
-    irCode(irCode)
+    CodeGenerator(size, Xbyak::AutoGrow),
+    irModule(),
+    cellSize(DEFAULT_CELL_SIZE),
+    memorySize(DEFAULT_MEMORY_SIZE)
   {}
-  void setIRCode(BfIR& irCode) { this->irCode = irCode; }
+  BfJitCompiler(const BfIRModule &irModule, std::size_t size=DEFAULT_GENERATOR_SIZE) :
+    CodeGenerator(size, Xbyak::AutoGrow),
+    irModule(irModule),
+    cellSize(DEFAULT_CELL_SIZE),
+    memorySize(DEFAULT_MEMORY_SIZE)
+  {}
+  void setIRModule(const BfIRModule &irModule) { this->irModule = irModule; }
+  /*!
+   * @brief Set the width of the cell
+   * @param [in] cellSize  Width of the cell in bytes: 1, 2 or 4
+   */
+  void setCellSize(int cellSize) { this->cellSize = cellSize; }
+  int getCellSize(void) const { return cellSize; }
+  /*!
+   * @brief Set the number of the cells, which CHECK instructions test against
+   * @param [in] memorySize  The number of the cells in the tape
+   */
+  void setMemorySize(std::size_t memorySize) { this->memorySize = memorySize; }
+  std::size_t getMemorySize(void) const { return memorySize; }
   void compile(void);
+
+  static std::size_t estimateCodeSize(const BfIRModule &irModule);
+  static const unsigned char *getBufferedOutput(const unsigned char *frame, std::size_t &size);
 };
 #endif  // USE_XBYAK
 
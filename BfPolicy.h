@@ -0,0 +1,98 @@
+/*!
+ * @file BfPolicy.h
+ * @brief Policies which specialize the bytecode engine
+ * @author koturn
+ */
+#ifndef BF_POLICY_H
+#define BF_POLICY_H
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include "BfIO.h"
+#include "compat.h"
+
+
+namespace bf {
+
+
+/*!
+ * @brief I/O policy which passes the cells through BfIO
+ *
+ * Only the lower 8 bits of the cell are written, and EOF is stored as -1
+ * truncated to the width of the cell.
+ */
+class BfIOPolicy {
+public:
+  explicit BfIOPolicy(BfIO &io) :
+    io(io)
+  {}
+
+  template<typename CellT>
+  inline void put(CellT value) { io.put(static_cast<unsigned char>(value)); }
+  template<typename CellT>
+  inline CellT get(void) { return static_cast<CellT>(io.get()); }
+  inline void write(const std::string &str) { io.write(str.data(), str.size()); }
+
+private:
+  BfIO &io;
+};
+
+
+/*!
+ * @brief Bounds policy which ignores CHECK instructions
+ */
+class BfUncheckedBounds {
+public:
+  BfUncheckedBounds(const void *, std::size_t) {}
+
+  template<typename CellT>
+  inline void check(const CellT *, int, int) const {}
+};
+
+
+/*!
+ * @brief Bounds policy which tests CHECK instructions against the tape
+ */
+class BfCheckedBounds {
+public:
+  /*!
+   * @brief Constructor
+   * @param [in] begin  Pointer to the first cell of the tape
+   * @param [in] size   The number of the cells in the tape
+   */
+  BfCheckedBounds(const void *begin, std::size_t size) :
+    begin(begin),
+    size(static_cast<std::ptrdiff_t>(size))
+  {}
+
+  template<typename CellT>
+  inline void check(const CellT *ptr, int minOffset, int maxOffset) const;
+
+private:
+  const void *begin;
+  std::ptrdiff_t size;
+};
+
+
+/*!
+ * @brief Throw if the cells from ptr + minOffset to ptr + maxOffset are not
+ *        in the tape
+ * @tparam CellT  Type of the cell
+ * @param [in] ptr        Pointer to the current cell
+ * @param [in] minOffset  Offset of the lowest accessed cell
+ * @param [in] maxOffset  Offset of the highest accessed cell
+ */
+template<typename CellT>
+inline void
+BfCheckedBounds::check(const CellT *ptr, int minOffset, int maxOffset) const
+{
+  std::ptrdiff_t pos = ptr - static_cast<const CellT *>(begin);
+  if (pos + minOffset < 0 || pos + maxOffset >= size) {
+    throw std::runtime_error("Tape overflow: the pointer is out of the tape");
+  }
+}
+
+
+}  // namespace bf
+#endif  // BF_POLICY_H
@@ -0,0 +1,605 @@
+/*!
+ * @file BfSimd.cpp
+ * @brief SIMD kernels for Brainfuck engines
+ * @author koturn
+ */
+#if __cplusplus >= 201103L
+#  include <cstdint>
+#else
+#  include <stdint.h>
+#endif  // __cplusplus >= 201103L
+#include "BfSimd.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#  define BF_SIMD_X86
+#  include <immintrin.h>
+#  ifdef _MSC_VER
+#    include <intrin.h>
+#  endif  // _MSC_VER
+#endif  // defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+
+#if defined(__GNUC__)
+#  define BF_TARGET_SSE2   __attribute__((target("sse2")))
+#  define BF_TARGET_SSSE3  __attribute__((target("ssse3")))
+#  define BF_TARGET_AVX2   __attribute__((target("avx2")))
+#else
+#  define BF_TARGET_SSE2
+#  define BF_TARGET_SSSE3
+#  define BF_TARGET_AVX2
+#endif  // defined(__GNUC__)
+
+
+static bf::BfSimd::InstructionSet
+detectInstructionSet(void);
+
+template<typename CellT>
+static CellT *
+searchZeroScalar(CellT *ptr, int step);
+
+static std::size_t
+compactCommandsScalar(char *dst, const char *src, std::size_t size);
+
+#ifdef BF_SIMD_X86
+template<typename CellT>
+BF_TARGET_SSE2 static CellT *
+searchZeroSse2(CellT *ptr, int step);
+
+template<typename CellT>
+BF_TARGET_AVX2 static CellT *
+searchZeroAvx2(CellT *ptr, int step);
+
+template<typename CellT>
+BF_TARGET_SSE2 inline static unsigned int
+getZeroMaskSse2(const unsigned char *p);
+
+template<typename CellT>
+BF_TARGET_AVX2 inline static unsigned int
+getZeroMaskAvx2(const unsigned char *p);
+
+inline static int
+findLowestBit(unsigned int mask);
+
+inline static int
+findHighestBit(unsigned int mask);
+
+BF_TARGET_SSSE3 static std::size_t
+compactCommandsSsse3(char *dst, const char *src, std::size_t size);
+
+BF_TARGET_AVX2 static std::size_t
+compactCommandsAvx2(char *dst, const char *src, std::size_t size);
+
+BF_TARGET_SSSE3 inline static unsigned int
+getCommandMaskSsse3(__m128i v);
+
+BF_TARGET_AVX2 inline static unsigned int
+getCommandMaskAvx2(__m256i v);
+
+BF_TARGET_SSSE3 inline static char *
+compressBlockSsse3(char *dst, const char *src, unsigned int mask);
+
+
+/*!
+ * @brief Shuffle table which packs the selected bytes of 8-byte block
+ *
+ * The entry is indexed by the 8-bit mask of the selected bytes.
+ */
+struct CompressTable {
+  unsigned char shuffle[256][8];
+  unsigned char count[256];
+
+  CompressTable(void) :
+    shuffle(),
+    count()
+  {
+    for (unsigned int mask = 0; mask < 256; mask++) {
+      unsigned int n = 0;
+      for (unsigned int i = 0; i < 8; i++) {
+        if ((mask & (1U << i)) != 0) {
+          shuffle[mask][n++] = static_cast<unsigned char>(i);
+        }
+      }
+      for (unsigned int i = n; i < 8; i++) {
+        shuffle[mask][i] = 0x80;
+      }
+      count[mask] = static_cast<unsigned char>(n);
+    }
+  }
+};
+
+static const CompressTable compressTable;
+#endif  // BF_SIMD_X86
+
+
+
+
+namespace bf {
+
+
+/*!
+ * @brief Get the instruction set which is available on this CPU
+ * @return The most efficient instruction set
+ */
+BfSimd::InstructionSet
+BfSimd::getInstructionSet(void)
+{
+  static const InstructionSet instructionSet = detectInstructionSet();
+  return instructionSet;
+}
+
+
+/*!
+ * @brief Get the mask of movemask lanes which are visited by the scan
+ *
+ * Shift the mask by (address % stepBytes) to align it with the cells.
+ * @param [in] stepBytes  Stride of the scan in bytes, which must be a power
+ *                        of two and not greater than 32
+ * @return Mask of the lanes in the 32-byte vector
+ */
+unsigned int
+BfSimd::getLaneMask(std::size_t stepBytes)
+{
+  switch (stepBytes) {
+    case 1:
+      return 0xffffffffU;
+    case 2:
+      return 0x55555555U;
+    case 4:
+      return 0x11111111U;
+    case 8:
+      return 0x01010101U;
+    case 16:
+      return 0x00010001U;
+    default:
+      return 0x00000001U;
+  }
+}
+
+
+/*!
+ * @brief Select the search kernel for the CPU
+ * @tparam CellT  Type of the cell
+ * @return Pointer to the search kernel
+ */
+template<typename CellT>
+CellT *(*BfSimd::getSearchZeroKernel(void))(CellT *, int)
+{
+  typedef CellT *(*Kernel)(CellT *, int);
+#ifdef BF_SIMD_X86
+  static const Kernel kernel = getInstructionSet() == AVX2 ? searchZeroAvx2<CellT>
+    : getInstructionSet() != SCALAR ? searchZeroSse2<CellT>
+    : searchZeroScalar<CellT>;
+#else
+  static const Kernel kernel = searchZeroScalar<CellT>;
+#endif  // BF_SIMD_X86
+  return kernel;
+}
+
+
+template unsigned char *(*BfSimd::getSearchZeroKernel<unsigned char>(void))(unsigned char *, int);
+template unsigned short *(*BfSimd::getSearchZeroKernel<unsigned short>(void))(unsigned short *, int);
+template unsigned int *(*BfSimd::getSearchZeroKernel<unsigned int>(void))(unsigned int *, int);
+
+
+/*!
+ * @brief Copy the Brainfuck-characters in src to dst
+ *
+ * dst must have the room for size bytes, and it may be equal to src.
+ * @param [out] dst   Destination buffer
+ * @param [in]  src   Source buffer
+ * @param [in]  size  Size of the source buffer
+ * @return The number of bytes which are written to dst
+ */
+std::size_t
+BfSimd::compactCommands(char *dst, const char *src, std::size_t size)
+{
+  typedef std::size_t (*Kernel)(char *, const char *, std::size_t);
+#ifdef BF_SIMD_X86
+  static const Kernel kernel = getInstructionSet() == AVX2 ? compactCommandsAvx2
+    : getInstructionSet() == SSSE3 ? compactCommandsSsse3
+    : compactCommandsScalar;
+#else
+  static const Kernel kernel = compactCommandsScalar;
+#endif  // BF_SIMD_X86
+  return kernel(dst, src, size);
+}
+
+
+}  // namespace bf
+
+
+
+
+/*!
+ * @brief Detect the instruction set with CPUID
+ * @return The most efficient instruction set
+ */
+static bf::BfSimd::InstructionSet
+detectInstructionSet(void)
+{
+#if defined(BF_SIMD_X86) && defined(__GNUC__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return bf::BfSimd::AVX2;
+  } else if (__builtin_cpu_supports("ssse3")) {
+    return bf::BfSimd::SSSE3;
+  } else if (__builtin_cpu_supports("sse2")) {
+    return bf::BfSimd::SSE2;
+  }
+#elif defined(BF_SIMD_X86) && defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 0);
+  int nIds = info[0];
+  __cpuid(info, 1);
+  bool hasSse2 = (info[3] & (1 << 26)) != 0;
+  bool hasSsse3 = (info[2] & (1 << 9)) != 0;
+  bool hasOsxsave = (info[2] & (1 << 27)) != 0;
+  if (nIds >= 7 && hasOsxsave && (_xgetbv(0) & 0x06) == 0x06) {
+    __cpuidex(info, 7, 0);
+    if ((info[1] & (1 << 5)) != 0) {
+      return bf::BfSimd::AVX2;
+    }
+  }
+  if (hasSsse3) {
+    return bf::BfSimd::SSSE3;
+  } else if (hasSse2) {
+    return bf::BfSimd::SSE2;
+  }
+#endif  // defined(BF_SIMD_X86) && defined(__GNUC__)
+  return bf::BfSimd::SCALAR;
+}
+
+
+/*!
+ * @brief Find the first zero cell one by one
+ * @tparam CellT  Type of the cell
+ * @param [in] ptr   Pointer to the current cell
+ * @param [in] step  Stride of the scan
+ * @return Pointer to the zero cell
+ */
+template<typename CellT>
+static CellT *
+searchZeroScalar(CellT *ptr, int step)
+{
+  while (*ptr != 0) {
+    ptr += step;
+  }
+  return ptr;
+}
+
+
+/*!
+ * @brief Copy the Brainfuck-characters one by one
+ *
+ * This is the reference implementation of the SIMD kernels.
+ * @param [out] dst   Destination buffer
+ * @param [in]  src   Source buffer
+ * @param [in]  size  Size of the source buffer
+ * @return The number of bytes which are written to dst
+ */
+static std::size_t
+compactCommandsScalar(char *dst, const char *src, std::size_t size)
+{
+  char *dstptr = dst;
+  for (const char *srcptr = src; srcptr != src + size; srcptr++) {
+    switch (*srcptr) {
+      case '>':
+      case '<':
+      case '+':
+      case '-':
+      case '.':
+      case ',':
+      case '[':
+      case ']':
+        *dstptr++ = *srcptr;
+        break;
+    }
+  }
+  return static_cast<std::size_t>(dstptr - dst);
+}
+
+
+#ifdef BF_SIMD_X86
+/*!
+ * @brief Find the first zero cell with SSE2
+ *
+ * The scan reads only aligned 16-byte blocks, which never cross the page
+ * boundary, so that it doesn't fault on the bytes out of the tape.
+ * @tparam CellT  Type of the cell
+ * @param [in] ptr   Pointer to the current cell
+ * @param [in] step  Stride of the scan
+ * @return Pointer to the zero cell
+ */
+template<typename CellT>
+BF_TARGET_SSE2 static CellT *
+searchZeroSse2(CellT *ptr, int step)
+{
+  static const std::size_t SIZE = 16;
+  std::size_t stepBytes = static_cast<std::size_t>(step < 0 ? -step : step) * sizeof(CellT);
+  if (stepBytes > SIZE || (stepBytes & (stepBytes - 1)) != 0) {
+    return searchZeroScalar(ptr, step);
+  }
+  unsigned char *p = static_cast<unsigned char *>(static_cast<void *>(ptr));
+  unsigned int r = static_cast<unsigned int>(reinterpret_cast<uintptr_t>(p) & (SIZE - 1));
+  unsigned int laneMask = bf::BfSimd::getLaneMask(stepBytes) << (r & (stepBytes - 1));
+  unsigned int mask;
+  p -= r;
+  if (step > 0) {
+    mask = getZeroMaskSse2<CellT>(p) & laneMask & (0xffffffffU << r);
+    while (mask == 0) {
+      p += SIZE;
+      mask = getZeroMaskSse2<CellT>(p) & laneMask;
+    }
+    p += findLowestBit(mask);
+  } else {
+    mask = getZeroMaskSse2<CellT>(p) & laneMask & ((2U << r) - 1);
+    while (mask == 0) {
+      p -= SIZE;
+      mask = getZeroMaskSse2<CellT>(p) & laneMask;
+    }
+    p += findHighestBit(mask);
+  }
+  return static_cast<CellT *>(static_cast<void *>(p));
+}
+
+
+/*!
+ * @brief Find the first zero cell with AVX2
+ *
+ * The scan reads only aligned 32-byte blocks, which never cross the page
+ * boundary, so that it doesn't fault on the bytes out of the tape.
+ * @tparam CellT  Type of the cell
+ * @param [in] ptr   Pointer to the current cell
+ * @param [in] step  Stride of the scan
+ * @return Pointer to the zero cell
+ */
+template<typename CellT>
+BF_TARGET_AVX2 static CellT *
+searchZeroAvx2(CellT *ptr, int step)
+{
+  static const std::size_t SIZE = 32;
+  std::size_t stepBytes = static_cast<std::size_t>(step < 0 ? -step : step) * sizeof(CellT);
+  if (stepBytes > SIZE || (stepBytes & (stepBytes - 1)) != 0) {
+    return searchZeroScalar(ptr, step);
+  }
+  unsigned char *p = static_cast<unsigned char *>(static_cast<void *>(ptr));
+  unsigned int r = static_cast<unsigned int>(reinterpret_cast<uintptr_t>(p) & (SIZE - 1));
+  unsigned int laneMask = bf::BfSimd::getLaneMask(stepBytes) << (r & (stepBytes - 1));
+  unsigned int mask;
+  p -= r;
+  if (step > 0) {
+    mask = getZeroMaskAvx2<CellT>(p) & laneMask & (0xffffffffU << r);
+    while (mask == 0) {
+      p += SIZE;
+      mask = getZeroMaskAvx2<CellT>(p) & laneMask;
+    }
+    p += findLowestBit(mask);
+  } else {
+    mask = getZeroMaskAvx2<CellT>(p) & laneMask & ((2U << r) - 1);
+    while (mask == 0) {
+      p -= SIZE;
+      mask = getZeroMaskAvx2<CellT>(p) & laneMask;
+    }
+    p += findHighestBit(mask);
+  }
+  return static_cast<CellT *>(static_cast<void *>(p));
+}
+
+
+/*!
+ * @brief Compare an aligned 16-byte block with zero
+ * @tparam CellT  Type of the cell
+ * @param [in] p  Pointer to the 16-byte aligned block
+ * @return Byte mask of the zero cells
+ */
+template<typename CellT>
+BF_TARGET_SSE2 inline static unsigned int
+getZeroMaskSse2(const unsigned char *p)
+{
+  __m128i v = _mm_load_si128(static_cast<const __m128i *>(static_cast<const void *>(p)));
+  __m128i zero = _mm_setzero_si128();
+  switch (sizeof(CellT)) {
+    case 1:
+      v = _mm_cmpeq_epi8(v, zero);
+      break;
+    case 2:
+      v = _mm_cmpeq_epi16(v, zero);
+      break;
+    default:
+      v = _mm_cmpeq_epi32(v, zero);
+      break;
+  }
+  return static_cast<unsigned int>(_mm_movemask_epi8(v));
+}
+
+
+/*!
+ * @brief Compare an aligned 32-byte block with zero
+ * @tparam CellT  Type of the cell
+ * @param [in] p  Pointer to the 32-byte aligned block
+ * @return Byte mask of the zero cells
+ */
+template<typename CellT>
+BF_TARGET_AVX2 inline static unsigned int
+getZeroMaskAvx2(const unsigned char *p)
+{
+  __m256i v = _mm256_load_si256(static_cast<const __m256i *>(static_cast<const void *>(p)));
+  __m256i zero = _mm256_setzero_si256();
+  switch (sizeof(CellT)) {
+    case 1:
+      v = _mm256_cmpeq_epi8(v, zero);
+      break;
+    case 2:
+      v = _mm256_cmpeq_epi16(v, zero);
+      break;
+    default:
+      v = _mm256_cmpeq_epi32(v, zero);
+      break;
+  }
+  return static_cast<unsigned int>(_mm256_movemask_epi8(v));
+}
+
+
+/*!
+ * @brief Get the index of the lowest set bit
+ * @param [in] mask  Non-zero bit mask
+ * @return Index of the lowest set bit
+ */
+inline static int
+findLowestBit(unsigned int mask)
+{
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return static_cast<int>(index);
+#else
+  return __builtin_ctz(mask);
+#endif  // _MSC_VER
+}
+
+
+/*!
+ * @brief Get the index of the highest set bit
+ * @param [in] mask  Non-zero bit mask
+ * @return Index of the highest set bit
+ */
+inline static int
+findHighestBit(unsigned int mask)
+{
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanReverse(&index, mask);
+  return static_cast<int>(index);
+#else
+  return 31 - __builtin_clz(mask);
+#endif  // _MSC_VER
+}
+
+
+/*!
+ * @brief Copy the Brainfuck-characters with SSSE3
+ *
+ * Each 16-byte block is classified with pshufb, and the selected bytes are
+ * packed with the shuffle table, 8 bytes at a time.
+ * @param [out] dst   Destination buffer
+ * @param [in]  src   Source buffer
+ * @param [in]  size  Size of the source buffer
+ * @return The number of bytes which are written to dst
+ */
+BF_TARGET_SSSE3 static std::size_t
+compactCommandsSsse3(char *dst, const char *src, std::size_t size)
+{
+  static const std::size_t SIZE = 16;
+  char *dstptr = dst;
+  const char *srcptr = src;
+  for (; srcptr + SIZE <= src + size; srcptr += SIZE) {
+    __m128i v = _mm_loadu_si128(static_cast<const __m128i *>(static_cast<const void *>(srcptr)));
+    unsigned int mask = getCommandMaskSsse3(v);
+    if (mask == 0xffff) {
+      _mm_storeu_si128(static_cast<__m128i *>(static_cast<void *>(dstptr)), v);
+      dstptr += SIZE;
+    } else if (mask != 0) {
+      dstptr = compressBlockSsse3(dstptr, srcptr, mask & 0xff);
+      dstptr = compressBlockSsse3(dstptr, srcptr + 8, mask >> 8);
+    }
+  }
+  return static_cast<std::size_t>(dstptr - dst)
+    + compactCommandsScalar(dstptr, srcptr, static_cast<std::size_t>(src + size - srcptr));
+}
+
+
+/*!
+ * @brief Copy the Brainfuck-characters with AVX2
+ *
+ * Each 32-byte block is classified with vpshufb, and the selected bytes are
+ * packed with the shuffle table, 8 bytes at a time.
+ * @param [out] dst   Destination buffer
+ * @param [in]  src   Source buffer
+ * @param [in]  size  Size of the source buffer
+ * @return The number of bytes which are written to dst
+ */
+BF_TARGET_AVX2 static std::size_t
+compactCommandsAvx2(char *dst, const char *src, std::size_t size)
+{
+  static const std::size_t SIZE = 32;
+  char *dstptr = dst;
+  const char *srcptr = src;
+  for (; srcptr + SIZE <= src + size; srcptr += SIZE) {
+    __m256i v = _mm256_loadu_si256(static_cast<const __m256i *>(static_cast<const void *>(srcptr)));
+    unsigned int mask = getCommandMaskAvx2(v);
+    if (mask == 0xffffffffU) {
+      _mm256_storeu_si256(static_cast<__m256i *>(static_cast<void *>(dstptr)), v);
+      dstptr += SIZE;
+    } else if (mask != 0) {
+      for (unsigned int i = 0; i < SIZE; i += 8) {
+        dstptr = compressBlockSsse3(dstptr, srcptr + i, (mask >> i) & 0xff);
+      }
+    }
+  }
+  return static_cast<std::size_t>(dstptr - dst)
+    + compactCommandsScalar(dstptr, srcptr, static_cast<std::size_t>(src + size - srcptr));
+}
+
+
+/*!
+ * @brief Classify 16 bytes into Brainfuck-characters and others
+ *
+ * Each byte is looked up by its low and high nibble, and it is
+ * Brainfuck-character if both lookups share a bit.
+ * <pre>
+ *   high nibble 2: + , - .  (bit 0)
+ *   high nibble 3: < >      (bit 1)
+ *   high nibble 5: [ ]      (bit 2)
+ * </pre>
+ * @param [in] v  16 bytes to classify
+ * @return Byte mask of the Brainfuck-characters
+ */
+BF_TARGET_SSSE3 inline static unsigned int
+getCommandMaskSsse3(__m128i v)
+{
+  const __m128i loTable = _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 5, 3, 5, 3, 0);
+  const __m128i hiTable = _mm_setr_epi8(0, 0, 1, 2, 0, 4, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m128i nibbleMask = _mm_set1_epi8(0x0f);
+  __m128i lo = _mm_shuffle_epi8(loTable, _mm_and_si128(v, nibbleMask));
+  __m128i hi = _mm_shuffle_epi8(hiTable, _mm_and_si128(_mm_srli_epi16(v, 4), nibbleMask));
+  __m128i other = _mm_cmpeq_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128());
+  return static_cast<unsigned int>(_mm_movemask_epi8(other)) ^ 0xffffU;
+}
+
+
+/*!
+ * @brief Classify 32 bytes into Brainfuck-characters and others
+ * @param [in] v  32 bytes to classify
+ * @return Byte mask of the Brainfuck-characters
+ * @see getCommandMaskSsse3
+ */
+BF_TARGET_AVX2 inline static unsigned int
+getCommandMaskAvx2(__m256i v)
+{
+  const __m256i loTable = _mm256_broadcastsi128_si256(_mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 5, 3, 5, 3, 0));
+  const __m256i hiTable = _mm256_broadcastsi128_si256(_mm_setr_epi8(0, 0, 1, 2, 0, 4, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0));
+  const __m256i nibbleMask = _mm256_set1_epi8(0x0f);
+  __m256i lo = _mm256_shuffle_epi8(loTable, _mm256_and_si256(v, nibbleMask));
+  __m256i hi = _mm256_shuffle_epi8(hiTable, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibbleMask));
+  __m256i other = _mm256_cmpeq_epi8(_mm256_and_si256(lo, hi), _mm256_setzero_si256());
+  return ~static_cast<unsigned int>(_mm256_movemask_epi8(other));
+}
+
+
+/*!
+ * @brief Pack the selected bytes of 8-byte block
+ *
+ * 8 bytes are always stored, so that dst must have the room for 8 bytes.
+ * @param [out] dst   Destination buffer
+ * @param [in]  src   8-byte block
+ * @param [in]  mask  8-bit mask of the selected bytes
+ * @return Pointer to the next of the last stored byte
+ */
+BF_TARGET_SSSE3 inline static char *
+compressBlockSsse3(char *dst, const char *src, unsigned int mask)
+{
+  __m128i v = _mm_loadl_epi64(static_cast<const __m128i *>(static_cast<const void *>(src)));
+  __m128i shuffle = _mm_loadl_epi64(static_cast<const __m128i *>(static_cast<const void *>(compressTable.shuffle[mask])));
+  _mm_storel_epi64(static_cast<__m128i *>(static_cast<void *>(dst)), _mm_shuffle_epi8(v, shuffle));
+  return dst + compressTable.count[mask];
+}
+#endif  // BF_SIMD_X86
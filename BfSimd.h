@@ -0,0 +1,59 @@
+/*!
+ * @file BfSimd.h
+ * @brief SIMD kernels for Brainfuck engines
+ * @author koturn
+ */
+#ifndef BF_SIMD_H
+#define BF_SIMD_H
+
+#include <cstddef>
+#include "compat.h"
+
+
+namespace bf {
+
+
+/*!
+ * @brief SIMD kernels for Brainfuck engines
+ *
+ * The kernel is selected at runtime with CPUID, so that the binary runs on
+ * the CPU which doesn't support AVX2.
+ */
+class BfSimd {
+public:
+  typedef enum {
+    SCALAR, SSE2, SSSE3, AVX2
+  } InstructionSet;
+
+  static InstructionSet getInstructionSet(void);
+  static unsigned int getLaneMask(std::size_t stepBytes);
+  static std::size_t compactCommands(char *dst, const char *src, std::size_t size);
+  template<typename CellT>
+  static inline CellT *searchZero(CellT *ptr, int step);
+
+private:
+  template<typename CellT>
+  static CellT *(*getSearchZeroKernel(void))(CellT *, int);
+};
+
+
+/*!
+ * @brief Find the first zero cell from ptr with the stride of step
+ *
+ * This function is equivalent to <code>while (*ptr) ptr += step;</code>.
+ * Stride of ±1, ±2 and ±4 cells are scanned with SIMD instructions.
+ * @tparam CellT  Type of the cell: unsigned char, unsigned short or unsigned int
+ * @param [in] ptr   Pointer to the current cell
+ * @param [in] step  Stride of the scan
+ * @return Pointer to the zero cell
+ */
+template<typename CellT>
+inline CellT *
+BfSimd::searchZero(CellT *ptr, int step)
+{
+  return *ptr == 0 ? ptr : getSearchZeroKernel<CellT>()(ptr, step);
+}
+
+
+}  // namespace bf
+#endif  // BF_SIMD_H
@@ -0,0 +1,167 @@
+/*!
+ * @file BfSourceFile.cpp
+ * @brief Read-only view of Brainfuck source file
+ * @author koturn
+ */
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#if defined(_WIN32) || defined(_WIN64)
+#  ifndef WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN_IS_NOT_DEFINED
+#  endif  // WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#  ifdef WIN32_LEAN_AND_MEAN_IS_NOT_DEFINED
+#    undef WIN32_LEAN_AND_MEAN_IS_NOT_DEFINED
+#    undef WIN32_LEAN_AND_MEAN
+#  endif  // WIN32_LEAN_AND_MEAN_IS_NOT_DEFINED
+#else
+#  include <cerrno>
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif  // defined(_WIN32) || defined(_WIN64)
+#include "BfSourceFile.h"
+
+
+namespace bf {
+
+
+/*!
+ * @brief Open the source file
+ *
+ * Previously opened file is closed.
+ * @param [in] filename  File path, or "-" for stdin
+ */
+void
+BfSourceFile::open(const char *filename)
+{
+  close();
+  bool isStdin = std::strcmp(filename, "-") == 0;
+#if defined(_WIN32) || defined(_WIN64)
+  HANDLE hFile = isStdin ? GetStdHandle(STD_INPUT_HANDLE)
+    : CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (hFile == INVALID_HANDLE_VALUE) {
+    throw std::runtime_error(std::string("Cannot open file: ") + filename);
+  }
+  LARGE_INTEGER fileSize;
+  if (!isStdin && GetFileType(hFile) == FILE_TYPE_DISK && GetFileSizeEx(hFile, &fileSize) && fileSize.QuadPart > 0) {
+    HANDLE hMap = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (hMap != nullptr) {
+      // The view keeps the mapping alive
+      LPVOID view = MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0);
+      CloseHandle(hMap);
+      if (view != nullptr) {
+        data = static_cast<const char *>(view);
+        size = static_cast<std::size_t>(fileSize.QuadPart);
+        mapped = true;
+        CloseHandle(hFile);
+        return;
+      }
+    }
+  }
+  handle = hFile;
+#else
+  int fileFd = isStdin ? STDIN_FILENO : ::open(filename, O_RDONLY);
+  if (fileFd == -1) {
+    throw std::runtime_error(std::string("Cannot open file: ") + filename);
+  }
+  struct stat st;
+  if (!isStdin && fstat(fileFd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    std::size_t fileSize = static_cast<std::size_t>(st.st_size);
+    void *view = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fileFd, 0);
+    if (view != MAP_FAILED) {
+#ifdef MADV_SEQUENTIAL
+      madvise(view, fileSize, MADV_SEQUENTIAL);
+#endif  // MADV_SEQUENTIAL
+      data = static_cast<const char *>(view);
+      size = fileSize;
+      mapped = true;
+      ::close(fileFd);
+      return;
+    }
+  }
+  fd = fileFd;
+#endif  // defined(_WIN32) || defined(_WIN64)
+  // Pipes and devices can't be mapped
+  ownsHandle = !isStdin;
+  buffer.resize(READ_BLOCK_SIZE);
+}
+
+
+/*!
+ * @brief Release the view
+ */
+void
+BfSourceFile::close(void)
+{
+  if (mapped) {
+#if defined(_WIN32) || defined(_WIN64)
+    UnmapViewOfFile(data);
+#else
+    munmap(const_cast<char *>(data), size);
+#endif  // defined(_WIN32) || defined(_WIN64)
+  }
+#if defined(_WIN32) || defined(_WIN64)
+  if (ownsHandle) {
+    CloseHandle(handle);
+  }
+  handle = nullptr;
+#else
+  if (ownsHandle) {
+    ::close(fd);
+  }
+  fd = -1;
+#endif  // defined(_WIN32) || defined(_WIN64)
+  std::vector<char>().swap(buffer);
+  data = nullptr;
+  size = 0;
+  pos = 0;
+  mapped = false;
+  ownsHandle = false;
+}
+
+
+/*!
+ * @brief Get the next block of the content
+ *
+ * The block is valid until the next call of readBlock() or close().
+ * @param [out] blockSize  Size of the block
+ * @return Pointer to the block, or nullptr on EOF
+ */
+const char *
+BfSourceFile::readBlock(std::size_t &blockSize)
+{
+  if (mapped) {
+    const char *block = data + pos;
+    blockSize = size - pos;
+    pos = size;
+    return blockSize == 0 ? nullptr : block;
+  }
+  blockSize = 0;
+  if (buffer.empty()) {
+    return nullptr;
+  }
+#if defined(_WIN32) || defined(_WIN64)
+  DWORD n;
+  if (ReadFile(handle, &buffer[0], static_cast<DWORD>(buffer.size()), &n, nullptr)) {
+    blockSize = n;
+  }
+#else
+  for (;;) {
+    ssize_t n = ::read(fd, &buffer[0], buffer.size());
+    if (n >= 0) {
+      blockSize = static_cast<std::size_t>(n);
+      break;
+    } else if (errno != EINTR) {
+      break;
+    }
+  }
+#endif  // defined(_WIN32) || defined(_WIN64)
+  return blockSize == 0 ? nullptr : &buffer[0];
+}
+
+
+}  // namespace bf
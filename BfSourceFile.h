@@ -0,0 +1,74 @@
+/*!
+ * @file BfSourceFile.h
+ * @brief Read-only view of Brainfuck source file
+ * @author koturn
+ */
+#ifndef BF_SOURCE_FILE_H
+#define BF_SOURCE_FILE_H
+
+#include <cstddef>
+#include <vector>
+#include "compat.h"
+
+
+namespace bf {
+
+
+/*!
+ * @brief Read-only view of Brainfuck source file
+ *
+ * The content is consumed block by block with readBlock().
+ * Regular files are memory-mapped and returned as one block, so that the
+ * content is not copied.
+ * Pipes, character devices and stdin ("-") can't be mapped, so that they
+ * are read into the fixed-size buffer, and the whole content is never held
+ * in memory.
+ * Blocks are not NUL-terminated.
+ */
+class BfSourceFile {
+public:
+  BfSourceFile(void) :
+    data(nullptr),
+    size(0),
+    pos(0),
+    mapped(false),
+#if defined(_WIN32) || defined(_WIN64)
+    handle(nullptr),
+#else
+    fd(-1),
+#endif  // defined(_WIN32) || defined(_WIN64)
+    ownsHandle(false),
+    buffer()
+  {}
+  ~BfSourceFile(void)
+  {
+    close();
+  }
+
+  void open(const char *filename);
+  void close(void);
+  const char *readBlock(std::size_t &blockSize);
+  inline bool isMapped(void) const { return mapped; }
+
+private:
+  static const std::size_t READ_BLOCK_SIZE = 65536;
+
+  const char *data;
+  std::size_t size;
+  std::size_t pos;
+  bool mapped;
+#if defined(_WIN32) || defined(_WIN64)
+  void *handle;
+#else
+  int fd;
+#endif  // defined(_WIN32) || defined(_WIN64)
+  bool ownsHandle;
+  std::vector<char> buffer;
+
+  BfSourceFile(const BfSourceFile &);
+  BfSourceFile &operator=(const BfSourceFile &);
+};
+
+
+}  // namespace bf
+#endif  // BF_SOURCE_FILE_H
@@ -0,0 +1,300 @@
+/*!
+ * @file BfTape.cpp
+ * @brief Growable tape for Brainfuck engines
+ * @author koturn
+ */
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#if __cplusplus >= 201103L
+#  include <cstdint>
+#else
+#  include <stdint.h>
+#endif  // __cplusplus >= 201103L
+#if defined(_WIN32) || defined(_WIN64)
+#  ifndef WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN_IS_NOT_DEFINED
+#  endif  // WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#  ifdef WIN32_LEAN_AND_MEAN_IS_NOT_DEFINED
+#    undef WIN32_LEAN_AND_MEAN_IS_NOT_DEFINED
+#    undef WIN32_LEAN_AND_MEAN
+#  endif  // WIN32_LEAN_AND_MEAN_IS_NOT_DEFINED
+#else
+#  include <csignal>
+#  include <sys/mman.h>
+#  include <unistd.h>
+#  if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#    define MAP_ANONYMOUS  MAP_ANON
+#  endif  // !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#  ifndef MAP_NORESERVE
+#    define MAP_NORESERVE  0
+#  endif  // MAP_NORESERVE
+#endif  // defined(_WIN32) || defined(_WIN64)
+#include "BfTape.h"
+
+
+inline static std::size_t
+roundUp(std::size_t size, std::size_t unit);
+
+#if defined(_WIN32) || defined(_WIN64)
+static LONG CALLBACK
+handleFault(PEXCEPTION_POINTERS info);
+#else
+static void
+handleFault(int sig, siginfo_t *info, void *context);
+#endif  // defined(_WIN32) || defined(_WIN64)
+
+static void
+reportOverflow(const bf::BfTape *tape);
+
+//! The tape which is alive
+static bf::BfTape *activeTape = nullptr;
+#if defined(_WIN32) || defined(_WIN64)
+//! Handle of the registered fault handler
+static PVOID faultHandler = nullptr;
+#else
+//! Signal actions which were installed before the tape
+static struct sigaction oldSegvAction;
+static struct sigaction oldBusAction;
+#endif  // defined(_WIN32) || defined(_WIN64)
+
+
+
+
+namespace bf {
+
+
+/*!
+ * @brief Constructor: Reserve the address range and commit its head
+ * @param [in] size         Initial size of the tape in bytes
+ * @param [in] reserveSize  Maximum size of the tape in bytes; if it can't be
+ *                          reserved, the tape doesn't grow
+ */
+BfTape::BfTape(std::size_t size, std::size_t reserveSize) :
+  mapping(nullptr),
+  mappingSize(0),
+  base(nullptr),
+  committedSize(0),
+  reservedSize(0),
+  pageSize(0),
+  io(nullptr),
+  faultHook(nullptr)
+{
+  if (activeTape != nullptr) {
+    throw std::logic_error("BfTape: only one tape can be alive at a time");
+  }
+#if defined(_WIN32) || defined(_WIN64)
+  SYSTEM_INFO systemInfo;
+  GetSystemInfo(&systemInfo);
+  pageSize = systemInfo.dwPageSize;
+#else
+  pageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#endif  // defined(_WIN32) || defined(_WIN64)
+  committedSize = roundUp(size == 0 ? 1 : size, pageSize);
+  reservedSize = roundUp(reserveSize, pageSize);
+  if (reservedSize < committedSize) {
+    reservedSize = committedSize;
+  }
+  // The guard regions before and after the reserved range are never committed
+  for (;;) {
+    mappingSize = reservedSize + 2 * GUARD_SIZE;
+#if defined(_WIN32) || defined(_WIN64)
+    mapping = static_cast<unsigned char *>(VirtualAlloc(nullptr, mappingSize, MEM_RESERVE, PAGE_NOACCESS));
+#else
+    void *p = mmap(nullptr, mappingSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    mapping = p == MAP_FAILED ? nullptr : static_cast<unsigned char *>(p);
+#endif  // defined(_WIN32) || defined(_WIN64)
+    if (mapping != nullptr) {
+      break;
+    } else if (reservedSize == committedSize) {
+      throw std::bad_alloc();
+    }
+    reservedSize = committedSize;
+  }
+  base = mapping + GUARD_SIZE;
+#if defined(_WIN32) || defined(_WIN64)
+  if (VirtualAlloc(base, committedSize, MEM_COMMIT, PAGE_READWRITE) == nullptr) {
+    VirtualFree(mapping, 0, MEM_RELEASE);
+    throw std::bad_alloc();
+  }
+  faultHandler = AddVectoredExceptionHandler(1, handleFault);
+#else
+  if (mprotect(base, committedSize, PROT_READ | PROT_WRITE) != 0) {
+    munmap(mapping, mappingSize);
+    throw std::bad_alloc();
+  }
+  struct sigaction action;
+  action.sa_sigaction = handleFault;
+  action.sa_flags = SA_SIGINFO;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGSEGV, &action, &oldSegvAction);
+  sigaction(SIGBUS, &action, &oldBusAction);
+#endif  // defined(_WIN32) || defined(_WIN64)
+  activeTape = this;
+}
+
+
+/*!
+ * @brief Destructor: Release the address range
+ */
+BfTape::~BfTape(void)
+{
+#if defined(_WIN32) || defined(_WIN64)
+  RemoveVectoredExceptionHandler(faultHandler);
+  faultHandler = nullptr;
+  VirtualFree(mapping, 0, MEM_RELEASE);
+#else
+  sigaction(SIGSEGV, &oldSegvAction, nullptr);
+  sigaction(SIGBUS, &oldBusAction, nullptr);
+  munmap(mapping, mappingSize);
+#endif  // defined(_WIN32) || defined(_WIN64)
+  activeTape = nullptr;
+}
+
+
+/*!
+ * @brief Check whether the address is in the tape or its guard regions
+ * @param [in] addr  Address to check
+ * @return true if the address is in the tape or its guard regions
+ */
+bool
+BfTape::contains(const void *addr) const
+{
+  uintptr_t p = reinterpret_cast<uintptr_t>(addr);
+  uintptr_t head = reinterpret_cast<uintptr_t>(mapping);
+  return head <= p && p - head < mappingSize;
+}
+
+
+/*!
+ * @brief Commit the reserved pages up to the address
+ *
+ * This function is called from the fault handler, so that it must be
+ * async-signal-safe.
+ * @param [in] addr  Faulted address
+ * @return true if the address is committed, false if it is out of the
+ *         reserved range
+ */
+bool
+BfTape::grow(const void *addr)
+{
+  uintptr_t p = reinterpret_cast<uintptr_t>(addr);
+  uintptr_t head = reinterpret_cast<uintptr_t>(base);
+  if (p < head || p - head >= reservedSize || p - head < committedSize) {
+    return false;
+  }
+  std::size_t newSize = roundUp(roundUp(static_cast<std::size_t>(p - head) + 1, GROW_SIZE), pageSize);
+  if (newSize > reservedSize) {
+    newSize = reservedSize;
+  }
+#if defined(_WIN32) || defined(_WIN64)
+  if (VirtualAlloc(base + committedSize, newSize - committedSize, MEM_COMMIT, PAGE_READWRITE) == nullptr) {
+    return false;
+  }
+#else
+  if (mprotect(base + committedSize, newSize - committedSize, PROT_READ | PROT_WRITE) != 0) {
+    return false;
+  }
+#endif  // defined(_WIN32) || defined(_WIN64)
+  committedSize = newSize;
+  return true;
+}
+
+
+}  // namespace bf
+
+
+
+
+/*!
+ * @brief Round up the size to the multiple of unit
+ * @param [in] size  Size
+ * @param [in] unit  Unit, which must be a power of two
+ * @return Rounded size
+ */
+inline static std::size_t
+roundUp(std::size_t size, std::size_t unit)
+{
+  return (size + unit - 1) & ~(unit - 1);
+}
+
+
+#if defined(_WIN32) || defined(_WIN64)
+/*!
+ * @brief Grow the tape on the access violation
+ * @param [in] info  Information of the exception
+ * @return EXCEPTION_CONTINUE_EXECUTION if the tape is grown, otherwise
+ *         EXCEPTION_CONTINUE_SEARCH
+ */
+static LONG CALLBACK
+handleFault(PEXCEPTION_POINTERS info)
+{
+  const EXCEPTION_RECORD *record = info->ExceptionRecord;
+  if (record->ExceptionCode != EXCEPTION_ACCESS_VIOLATION || activeTape == nullptr) {
+    return EXCEPTION_CONTINUE_SEARCH;
+  }
+  const void *addr = reinterpret_cast<const void *>(record->ExceptionInformation[1]);
+  if (!activeTape->contains(addr)) {
+    return EXCEPTION_CONTINUE_SEARCH;
+  } else if (activeTape->grow(addr)) {
+    return EXCEPTION_CONTINUE_EXECUTION;
+  }
+  reportOverflow(activeTape);
+  return EXCEPTION_CONTINUE_SEARCH;
+}
+#else
+/*!
+ * @brief Grow the tape on SIGSEGV and SIGBUS
+ *
+ * If the fault is not caused by the tape, the previous signal action is
+ * restored, and the faulted instruction raises the signal again.
+ * @param [in] sig      Signal number
+ * @param [in] info     Information of the signal
+ * @param [in] context  Unused
+ */
+static void
+handleFault(int sig, siginfo_t *info, void *context)
+{
+  static_cast<void>(context);
+  if (activeTape != nullptr && activeTape->contains(info->si_addr)) {
+    if (activeTape->grow(info->si_addr)) {
+      return;
+    }
+    reportOverflow(activeTape);
+  }
+  sigaction(sig, sig == SIGSEGV ? &oldSegvAction : &oldBusAction, nullptr);
+}
+#endif  // defined(_WIN32) || defined(_WIN64)
+
+
+/*!
+ * @brief Report the tape overflow and exit
+ *
+ * Buffered output of the I/O and the output written by the fault hook are
+ * written by its async-signal-safe backend before the message, because exit
+ * handlers can't be used safely in the fault handler.
+ * @param [in] tape  Tape which overflowed
+ */
+static void
+reportOverflow(const bf::BfTape *tape)
+{
+  bf::BfIO *io = tape->getIO();
+  if (io != nullptr) {
+    io->flushOnFault();
+    if (tape->getFaultHook() != nullptr) {
+      tape->getFaultHook()(io);
+    }
+  }
+  static const char MESSAGE[] = "Tape overflow: the pointer is out of the tape\n";
+#if defined(_WIN32) || defined(_WIN64)
+  DWORD n;
+  WriteFile(GetStdHandle(STD_ERROR_HANDLE), MESSAGE, sizeof(MESSAGE) - 1, &n, nullptr);
+  ExitProcess(EXIT_FAILURE);
+#else
+  ssize_t n = write(STDERR_FILENO, MESSAGE, sizeof(MESSAGE) - 1);
+  static_cast<void>(n);
+  _exit(EXIT_FAILURE);
+#endif  // defined(_WIN32) || defined(_WIN64)
+}
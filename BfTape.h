@@ -0,0 +1,91 @@
+/*!
+ * @file BfTape.h
+ * @brief Growable tape for Brainfuck engines
+ * @author koturn
+ */
+#ifndef BF_TAPE_H
+#define BF_TAPE_H
+
+#include <cstddef>
+#include "compat.h"
+#include "BfIO.h"
+
+
+namespace bf {
+
+
+/*!
+ * @brief Growable tape for Brainfuck engines
+ *
+ * A large address range is reserved without access permission, and only its
+ * head is committed.
+ * Committed pages are zero-filled by the OS on the first touch, so that the
+ * tape needn't be cleared.
+ * Access to the reserved pages is caught by the fault handler, which commits
+ * them and resumes the access, so that the tape grows on demand without any
+ * check in the engines.
+ * The guard regions of GUARD_SIZE bytes before the tape and beyond the
+ * reserved range are never committed, and access to them is reported as the
+ * tape overflow, and the process exits after the buffered output of the I/O
+ * which is set by setIO() is flushed, followed by the output which is written
+ * by the hook set by setFaultHook().
+ * GUARD_SIZE covers the pointer movement and the offsets of the compiled
+ * code, which are limited to BfIRCompiler::MAX_OFFSET cells, so that the
+ * pointer can't skip over the guard regions between two accesses.
+ * Only one tape can be alive at a time.
+ */
+class BfTape {
+public:
+  /*!
+   * @brief Function which writes the output held out of the I/O to it
+   *
+   * It is called from the fault handler, so it must be async-signal-safe.
+   */
+  typedef void (*FaultHook)(BfIO *io);
+
+  static const std::size_t DEFAULT_RESERVE_SIZE = sizeof(void *) >= 8 ? 1024 * 1024 * 1024 : 64 * 1024 * 1024;
+  //! Size of each guard region, which exceeds a move and two offsets of BfIRCompiler::MAX_OFFSET 4-byte cells
+  static const std::size_t GUARD_SIZE = 4 * 4 * 4 * 1024 * 1024;
+
+  explicit BfTape(std::size_t size, std::size_t reserveSize=DEFAULT_RESERVE_SIZE);
+  ~BfTape(void);
+
+  /*!
+   * @brief Get the head of the tape
+   * @return Pointer to the first cell
+   */
+  inline unsigned char *get(void) const { return base; }
+  /*!
+   * @brief Set the I/O whose buffered output is flushed on the tape overflow
+   * @param [in] io  I/O of the engine, or nullptr
+   */
+  inline void setIO(BfIO *io) { this->io = io; }
+  inline BfIO *getIO(void) const { return io; }
+  /*!
+   * @brief Set the hook which is called on the tape overflow
+   * @param [in] faultHook  Hook, or nullptr
+   */
+  inline void setFaultHook(FaultHook faultHook) { this->faultHook = faultHook; }
+  inline FaultHook getFaultHook(void) const { return faultHook; }
+  bool contains(const void *addr) const;
+  bool grow(const void *addr);
+
+private:
+  static const std::size_t GROW_SIZE = 65536;
+
+  unsigned char *mapping;
+  std::size_t mappingSize;
+  unsigned char *base;
+  std::size_t committedSize;
+  std::size_t reservedSize;
+  std::size_t pageSize;
+  BfIO *io;
+  FaultHook faultHook;
+
+  BfTape(const BfTape &);
+  BfTape &operator=(const BfTape &);
+};
+
+
+}  // namespace bf
+#endif  // BF_TAPE_H
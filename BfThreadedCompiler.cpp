@@ -0,0 +1,307 @@
+/*!
+ * @file BfThreadedCompiler.cpp
+ * @brief Brainfuck-IR to direct-threaded code compiler
+ * @author koturn
+ */
+#include "BfSimd.h"
+#include "BfThreadedCompiler.h"
+
+#if defined(BF_USE_COMPUTED_GOTO) && defined(__GNUC__)
+// Labels as values and computed goto are GNU extensions
+#  pragma GCC diagnostic ignored "-Wpedantic"
+#endif  // defined(BF_USE_COMPUTED_GOTO) && defined(__GNUC__)
+
+
+namespace bf {
+
+
+/*!
+ * @brief Compile brainfuck IR code into direct-threaded code
+ */
+void
+BfThreadedCompiler::compile(void)
+{
+  const BfIR &irCode = irModule.getCode();
+  threadedCode.clear();
+  threadedCode.reserve(irCode.size() + 1);
+  // Index of the threaded code for each position of the IR, which differ
+  // because some instructions emit nothing
+  std::vector<int> indices;
+  indices.reserve(irCode.size() + 1);
+  std::vector<std::size_t> jumps;
+  for (BfIR::const_iterator cmd = irCode.begin(), end = irCode.end(); cmd != end; cmd++) {
+    indices.push_back(static_cast<int>(threadedCode.size()));
+    switch (cmd->type) {
+      case BfInstruction::NEXT:
+        emit(MOVE, 1);
+        break;
+      case BfInstruction::PREV:
+        emit(MOVE, -1);
+        break;
+      case BfInstruction::NEXT_N:
+        emit(MOVE, cmd->value1);
+        break;
+      case BfInstruction::PREV_N:
+        emit(MOVE, -cmd->value1);
+        break;
+      case BfInstruction::INC:
+        emit(ADD, 1);
+        break;
+      case BfInstruction::DEC:
+        emit(ADD, -1);
+        break;
+      case BfInstruction::ADD:
+        emit(ADD, cmd->value1);
+        break;
+      case BfInstruction::SUB:
+        emit(ADD, -cmd->value1);
+        break;
+      case BfInstruction::INC_AT:
+        emit(ADD_AT, cmd->value1, 1);
+        break;
+      case BfInstruction::DEC_AT:
+        emit(ADD_AT, cmd->value1, -1);
+        break;
+      case BfInstruction::ADD_AT:
+        emit(ADD_AT, cmd->value1, cmd->value2);
+        break;
+      case BfInstruction::SUB_AT:
+        emit(ADD_AT, cmd->value1, -cmd->value2);
+        break;
+      case BfInstruction::PUTCHAR:
+        emit(PUTCHAR, cmd->value1);
+        break;
+      case BfInstruction::GETCHAR:
+        emit(GETCHAR, cmd->value1);
+        break;
+      case BfInstruction::LOOP_START:
+        // Jump to just behind the corresponding LOOP_END
+        jumps.push_back(threadedCode.size());
+        emit(LOOP_START, cmd->value1 + 1);
+        break;
+      case BfInstruction::LOOP_END:
+        // Jump to the top of the loop body
+        jumps.push_back(threadedCode.size());
+        emit(LOOP_END, cmd->value1 + 1);
+        break;
+      case BfInstruction::ASSIGN_ZERO:
+        emit(ASSIGN, 0);
+        break;
+      case BfInstruction::ASSIGN:
+        emit(ASSIGN, cmd->value1);
+        break;
+      case BfInstruction::ASSIGN_AT:
+        emit(ASSIGN_AT, cmd->value1, cmd->value2);
+        break;
+      case BfInstruction::SEARCH_ZERO:
+        emit(SEARCH_ZERO, cmd->value1);
+        break;
+      case BfInstruction::ADD_VAR:
+        emit(ADD_VAR, cmd->value1);
+        break;
+      case BfInstruction::SUB_VAR:
+        emit(SUB_VAR, cmd->value1);
+        break;
+      case BfInstruction::CMUL_VAR:
+        emit(CMUL_VAR, cmd->value1, cmd->value2);
+        break;
+      case BfInstruction::MULTI_CMUL_VAR:
+        emit(MULTI_CMUL_VAR, cmd->value1);
+        break;
+      case BfInstruction::CMUL_TARGET:
+        emit(CMUL_TARGET, cmd->value1, cmd->value2);
+        break;
+      case BfInstruction::INF_LOOP:
+        emit(INF_LOOP);
+        break;
+      case BfInstruction::CHECK:
+        // Not checked
+        break;
+      case BfInstruction::PUTS:
+        emit(PUTS, cmd->value1);
+        break;
+      case BfInstruction::IF:
+        // LOOP_START without the back edge; jump to just behind END_IF
+        jumps.push_back(threadedCode.size());
+        emit(LOOP_START, cmd->value1 + 1);
+        break;
+      case BfInstruction::END_IF:
+        break;
+    }
+  }
+  indices.push_back(static_cast<int>(threadedCode.size()));
+  emit(END);
+  // Jump targets are emitted as the positions of the IR
+  for (std::vector<std::size_t>::const_iterator itr = jumps.begin(), end = jumps.end(); itr != end; itr++) {
+    Instruction &inst = threadedCode[*itr];
+    inst.value1 = indices[static_cast<std::vector<int>::size_type>(inst.value1)];
+  }
+}
+
+
+/*!
+ * @brief Execute direct-threaded code
+ * @param [in,out] memory  Memory of brainfuck, which must be zero-filled
+ * @param [in,out] io      I/O of brainfuck
+ */
+void
+BfThreadedCompiler::execute(unsigned char *memory, BfIO &io) const
+{
+  if (threadedCode.empty()) {
+    return;
+  }
+  run(&threadedCode[0], memory, &io, &irModule.getStrings());
+}
+
+
+/*!
+ * @brief Append one instruction to threaded code
+ * @param [in] opcode  Opcode of the instruction
+ * @param [in] value1  First operand
+ * @param [in] value2  Second operand
+ */
+void
+BfThreadedCompiler::emit(Opcode opcode, int value1, int value2)
+{
+  Instruction inst;
+#ifdef BF_USE_COMPUTED_GOTO
+  static const Handler *handlers = run(nullptr, nullptr, nullptr, nullptr);
+  inst.handler = handlers[opcode];
+#else
+  inst.handler = opcode;
+#endif  // BF_USE_COMPUTED_GOTO
+  inst.value1 = value1;
+  inst.value2 = value2;
+  threadedCode.push_back(inst);
+}
+
+
+/*!
+ * @brief Run direct-threaded code
+ *
+ * If ip is nullptr, this function only returns the table of handler
+ * addresses which is indexed by Opcode.
+ * @param [in]     ip       Pointer to the first instruction
+ * @param [in,out] ptr      Pointer to the memory of brainfuck
+ * @param [in,out] io       I/O of brainfuck
+ * @param [in]     strings  String pool which PUTS refers to
+ * @return Table of handler addresses if ip is nullptr, otherwise nullptr
+ */
+const BfThreadedCompiler::Handler *
+BfThreadedCompiler::run(const Instruction *ip, unsigned char *ptr, BfIO *io, const BfStringPool *strings)
+{
+#ifdef BF_USE_COMPUTED_GOTO
+#  define CASE(opcode)  L_##opcode:
+#  define DISPATCH()    goto *ip->handler
+#  define NEXT()        ip++; DISPATCH()
+  static const Handler HANDLERS[] = {
+    &&L_MOVE, &&L_ADD, &&L_ADD_AT, &&L_ASSIGN, &&L_ASSIGN_AT,
+    &&L_PUTCHAR, &&L_GETCHAR, &&L_PUTS,
+    &&L_LOOP_START, &&L_LOOP_END,
+    &&L_SEARCH_ZERO, &&L_ADD_VAR, &&L_SUB_VAR, &&L_CMUL_VAR,
+    &&L_MULTI_CMUL_VAR, &&L_CMUL_TARGET,
+    &&L_INF_LOOP, &&L_END
+  };
+  if (ip == nullptr) {
+    return HANDLERS;
+  }
+  const Instruction *const code = ip;
+  DISPATCH();
+#else
+#  define CASE(opcode)  case opcode:
+#  define DISPATCH()    continue
+#  define NEXT()        ip++; DISPATCH()
+  if (ip == nullptr) {
+    return nullptr;
+  }
+  const Instruction *const code = ip;
+  for (;;) {
+    switch (ip->handler) {
+#endif  // BF_USE_COMPUTED_GOTO
+  CASE(MOVE)
+    ptr += ip->value1;
+    NEXT();
+  CASE(ADD)
+    *ptr = static_cast<unsigned char>(*ptr + ip->value1);
+    NEXT();
+  CASE(ADD_AT)
+    ptr[ip->value1] = static_cast<unsigned char>(ptr[ip->value1] + ip->value2);
+    NEXT();
+  CASE(ASSIGN)
+    *ptr = static_cast<unsigned char>(ip->value1);
+    NEXT();
+  CASE(ASSIGN_AT)
+    ptr[ip->value1] = static_cast<unsigned char>(ip->value2);
+    NEXT();
+  CASE(PUTCHAR)
+    io->put(ptr[ip->value1]);
+    NEXT();
+  CASE(GETCHAR)
+    ptr[ip->value1] = static_cast<unsigned char>(io->get());
+    NEXT();
+  CASE(PUTS)
+    {
+      const std::string &str = (*strings)[static_cast<BfStringPool::size_type>(ip->value1)];
+      io->write(str.data(), str.size());
+    }
+    NEXT();
+  CASE(LOOP_START)
+    if (*ptr == 0) {
+      ip = code + ip->value1;
+      DISPATCH();
+    }
+    NEXT();
+  CASE(LOOP_END)
+    if (*ptr != 0) {
+      ip = code + ip->value1;
+      DISPATCH();
+    }
+    NEXT();
+  CASE(SEARCH_ZERO)
+    ptr = BfSimd::searchZero(ptr, ip->value1);
+    NEXT();
+  CASE(ADD_VAR)
+    ptr[ip->value1] = static_cast<unsigned char>(ptr[ip->value1] + *ptr);
+    *ptr = 0;
+    NEXT();
+  CASE(SUB_VAR)
+    ptr[ip->value1] = static_cast<unsigned char>(ptr[ip->value1] - *ptr);
+    *ptr = 0;
+    NEXT();
+  CASE(CMUL_VAR)
+    ptr[ip->value1] = static_cast<unsigned char>(ptr[ip->value1] + *ptr * ip->value2);
+    *ptr = 0;
+    NEXT();
+  CASE(MULTI_CMUL_VAR)
+    {
+      // Operands are held by the following CMUL_TARGET instructions
+      const Instruction *target = ip + 1;
+      ip = target + ip->value1;
+      for (; target != ip; target++) {
+        ptr[target->value1] = static_cast<unsigned char>(ptr[target->value1] + *ptr * target->value2);
+      }
+      *ptr = 0;
+    }
+    DISPATCH();
+  CASE(CMUL_TARGET)
+    // Always consumed by MULTI_CMUL_VAR
+    NEXT();
+  CASE(INF_LOOP)
+    if (*ptr != 0) {
+      // Jump to itself forever
+      DISPATCH();
+    }
+    NEXT();
+  CASE(END)
+    return nullptr;
+#ifndef BF_USE_COMPUTED_GOTO
+    }
+  }
+#endif  // BF_USE_COMPUTED_GOTO
+#undef CASE
+#undef DISPATCH
+#undef NEXT
+}
+
+
+}  // namespace bf
@@ -0,0 +1,76 @@
+/*!
+ * @file BfThreadedCompiler.h
+ * @brief Brainfuck-IR to direct-threaded code compiler
+ * @author koturn
+ */
+#ifndef BF_THREADED_COMPILER_H
+#define BF_THREADED_COMPILER_H
+
+#include <vector>
+#include "BfIO.h"
+#include "BfIRCompiler.h"
+#include "compat.h"
+
+#if defined(__GNUC__) && !defined(BF_NO_COMPUTED_GOTO)
+#  define BF_USE_COMPUTED_GOTO
+#endif  // defined(__GNUC__) && !defined(BF_NO_COMPUTED_GOTO)
+
+
+namespace bf {
+
+
+/*!
+ * @brief Brainfuck-IR to direct-threaded code compiler
+ *
+ * Each instruction of threaded code holds the address of its handler and
+ * operands which are resolved at compile time, so that the interpreter can
+ * dispatch with one indirect jump per instruction.
+ * If the compiler doesn't support computed goto, handler is an opcode and
+ * the interpreter falls back to switch dispatch.
+ */
+class BfThreadedCompiler {
+public:
+  typedef enum {
+    MOVE, ADD, ADD_AT, ASSIGN, ASSIGN_AT,
+    PUTCHAR, GETCHAR, PUTS,
+    LOOP_START, LOOP_END,
+    SEARCH_ZERO, ADD_VAR, SUB_VAR, CMUL_VAR,
+    MULTI_CMUL_VAR, CMUL_TARGET,
+    INF_LOOP, END
+  } Opcode;
+
+#ifdef BF_USE_COMPUTED_GOTO
+  typedef const void *Handler;
+#else
+  typedef Opcode Handler;
+#endif  // BF_USE_COMPUTED_GOTO
+
+  struct Instruction {
+    Handler handler;
+    int value1;
+    int value2;
+  };
+
+  BfThreadedCompiler(void) :
+    irModule(),
+    threadedCode()
+  {}
+
+  inline void
+  setIRModule(const BfIRModule &irModule) {
+    this->irModule = irModule;
+  }
+  void compile(void);
+  void execute(unsigned char *memory, BfIO &io) const;
+
+private:
+  BfIRModule irModule;
+  std::vector<Instruction> threadedCode;
+
+  void emit(Opcode opcode, int value1=0, int value2=0);
+  static const Handler *run(const Instruction *ip, unsigned char *ptr, BfIO *io, const BfStringPool *strings);
+};
+
+
+}  // namespace bf
+#endif  // BF_THREADED_COMPILER_H
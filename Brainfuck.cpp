@@ -1,7 +1,7 @@
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <algorithm>
-#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <stack>
@@ -20,16 +20,28 @@
 #  include <xbyak/xbyak.h>
 #endif  // USE_XBYAK
 #include "Brainfuck.h"
+#include "BfPolicy.h"
+#include "BfSimd.h"
+#include "BfTape.h"
 #include "CodeGenerator/_AllGenerator.h"
 
 
 
+#ifdef USE_XBYAK
+static void
+flushJitOutput(const unsigned char *buf, std::size_t size);
+
+static int
+readJitInput(void);
 
-static const char *
-findLoopEnd(const char* srcptr);
+static void
+flushJitOutputOnFault(bf::BfIO *io);
 
-static const char *
-findLoopStart(const char* srcptr);
+//! I/O which JIT-compiled code is running with
+static bf::BfIO *jitIO = nullptr;
+//! Frame of JIT-compiled code which is running
+static unsigned char *jitFrame = nullptr;
+#endif  // USE_XBYAK
 
 
 
@@ -40,6 +52,9 @@ findLoopStart(const char* srcptr);
 namespace bf {
 
 
+const std::size_t Brainfuck::UNMATCHED_BRACKET;
+
+
 #if __cplusplus < 201103L
 /*!
  * @brief Destructor: Delete alocated memory
@@ -48,64 +63,55 @@ Brainfuck::~Brainfuck(void)
 {
   delete[] sourceBuffer;
   delete[] binCode;
+  delete jitCompiler;
 }
 #endif  // __cplusplus < 201103L
 
 
 /*!
  * @brief Load Brainfuck source code
- * @param [in] filename  File path
+ *
+ * Regular file is mapped into memory, and other files are read lazily by
+ * trim() or compile().
+ * @param [in] filename  File path, or "-" for stdin
  */
 void
 Brainfuck::load(const char *filename)
 {
-  std::ifstream ifs(filename);
-  if (ifs.fail()) {
-    throw std::runtime_error(std::string("Cannot open file: ") + filename);
-  }
-  ifs.seekg(0, ifs.end);
-  std::size_t fileSize = static_cast<std::size_t>(ifs.tellg());
-  ifs.seekg(0, ifs.beg);
-
-#if __cplusplus >= 201103L
-  sourceBuffer.reset(new char[fileSize]);
-  ifs.read(sourceBuffer.get(), fileSize);
-#else
-  sourceBuffer = new char[fileSize];
-  ifs.read(sourceBuffer, fileSize);
-#endif  // __cplusplus >= 201103L
-  sourceBuffer[fileSize - 1] = '\0';
+  sourceFile.open(filename);
 }
 
 
 /*!
  * @brief [in] Delete not Brainfuck-characters
+ *
+ * Brainfuck-characters in the loaded source are copied into the source buffer,
+ * and the loaded source is released.
+ * This is necessary only for the interpreter without compile, and it is
+ * called by execute() if it is not called yet.
  */
 void
 Brainfuck::trim(void)
 {
+  std::vector<char> commands;
+  std::size_t blockSize;
+  for (const char *block; (block = sourceFile.readBlock(blockSize)) != nullptr;) {
+    std::size_t n = commands.size();
+    commands.resize(n + blockSize);
+    commands.resize(n + BfSimd::compactCommands(&commands[n], block, blockSize));
+  }
+  sourceFile.close();
 #if __cplusplus >= 201103L
-  const char* srcptr = sourceBuffer.get();
+  sourceBuffer.reset(new char[commands.size() + 1]);
   char* dstptr = sourceBuffer.get();
 #else
-  const char* srcptr = sourceBuffer;
+  delete[] sourceBuffer;
+  sourceBuffer = new char[commands.size() + 1];
   char* dstptr = sourceBuffer;
 #endif  // __cplusplus >= 201103L
-  for (; *srcptr != '\0'; srcptr++) {
-    switch (*srcptr) {
-      case '>':
-      case '<':
-      case '+':
-      case '-':
-      case '.':
-      case ',':
-      case '[':
-      case ']':
-        *dstptr++ = *srcptr;
-        break;
-    }
-  }
+  dstptr = std::copy(commands.begin(), commands.end(), dstptr);
   *dstptr = '\0';
+  matchBrackets(commands);
 }
 
 
@@ -120,7 +126,10 @@ Brainfuck::compile(CompileType compileType)
     case NO_COMPILE:
       break;
     case NORMAL_COMPILE:
-      normalCompile();
+      bytecodeCompile();
+      break;
+    case THREADED_COMPILE:
+      threadedCompile();
       break;
 #ifdef USE_XBYAK
     case XBYAK_JIT_COMPILE:
@@ -139,18 +148,25 @@ Brainfuck::execute(void)
 {
   switch (compileType) {
     case NO_COMPILE:
+      if (sourceBuffer == nullptr) {
+        trim();
+      }
       interpretExecute();
       break;
     case NORMAL_COMPILE:
       compileExecute();
       break;
+    case THREADED_COMPILE:
+      threadedExecute();
+      break;
 #ifdef USE_XBYAK
     case XBYAK_JIT_COMPILE:
       xbyakJitExecute();
       break;
 #endif  // USE_XBYAK
   }
-  std::cout.put('\n');
+  io->put('\n');
+  io->flush();
 }
 
 
@@ -161,12 +177,11 @@ Brainfuck::execute(void)
 void
 Brainfuck::xbyakDump(void)
 {
-  std::size_t size = jitCompiler.getSize();
-  if (size == 0) {
+  if (compileType != XBYAK_JIT_COMPILE) {
     xbyakJitCompile();
-    size = jitCompiler.getSize();
   }
-  const Xbyak::uint8 *code = jitCompiler.getCode();
+  std::size_t size = jitCompiler->getSize();
+  const Xbyak::uint8 *code = jitCompiler->getCode();
 
   std::cout << "#include <stdio.h>\n"
                "#include <stdlib.h>\n"
@@ -185,7 +200,9 @@ Brainfuck::xbyakDump(void)
                "#include <sys/mman.h>\n"
 #endif
                "\n"
-               "static int stack[128 * 1024];\n"
+               "static unsigned "
+            << (cellSize == 1 ? "char" : cellSize == 2 ? "short" : "int")
+            << " stack[" << memorySize << "];\n"
                "static unsigned char code[] = {\n"
             << std::hex << " ";
   for (std::size_t i = 0; i < size; i++) {
@@ -197,17 +214,27 @@ Brainfuck::xbyakDump(void)
   }
   std::cout << std::dec
             << "\n};\n\n\n"
+               "static void\n"
+               "flush_output(const unsigned char *buf, size_t size)\n"
+               "{\n"
+               "  fwrite(buf, 1, size, stdout);\n"
+               "}\n\n\n"
                "int\n"
                "main(void)\n"
                "{\n"
+               "  unsigned char *frame;\n"
 #if defined(_WIN32) || defined(_WIN64) || (defined(__CYGWIN__) && defined(__x86_64__))
                "  DWORD old_protect;\n"
                "  VirtualProtect((LPVOID) code, sizeof(code), PAGE_EXECUTE_READWRITE, &old_protect);\n"
 #elif defined(__linux__)
-               "  long page_size = sysconf(_SC_PAGESIZE) - 1;\n"
-               "  mprotect((void *) code, (sizeof(code) + page_size) & ~page_size, PROT_READ | PROT_EXEC);\n"
+               "  unsigned long page_mask = (unsigned long) sysconf(_SC_PAGESIZE) - 1;\n"
+               "  unsigned long head = (unsigned long) code & ~page_mask;\n"
+               "  mprotect((void *) head, ((unsigned long) code + sizeof(code) - head + page_mask) & ~page_mask, PROT_READ | PROT_WRITE | PROT_EXEC);\n"
 #endif
-               "  ((void (*)(int (*)(int), int (*)(), int *)) (unsigned char *) code)(putchar, getchar, stack);\n"
+               "  if (((int (*)(void (*)(const unsigned char *, size_t), int (*)(), void *, unsigned char **)) (unsigned char *) code)(flush_output, getchar, stack, &frame) != 0) {\n"
+               "    fputs(\"Tape overflow: the pointer is out of the tape\\n\", stderr);\n"
+               "    return EXIT_FAILURE;\n"
+               "  }\n"
                "  return EXIT_SUCCESS;\n"
                "}"
             << std::endl;
@@ -222,48 +249,50 @@ Brainfuck::xbyakDump(void)
 void
 Brainfuck::translate(LANG lang)
 {
-  irCompiler.compile();
-  BfIR irCode = irCompiler.getCode();
+  if (irCompiler.getModule().empty()) {
+    normalCompile();
+  }
+  const BfIRModule &irModule = irCompiler.getModule();
   switch (lang) {
     case LANG_C:
       {
-        GeneratorC cGenerator(irCode);
+        GeneratorC cGenerator(irModule);
         cGenerator.genCode();
       }
       break;
     case LANG_CPP:
       {
-        GeneratorCpp cppGenerator(irCode);
+        GeneratorCpp cppGenerator(irModule);
         cppGenerator.genCode();
       }
       break;
     case LANG_CSHARP:
       {
-        GeneratorCSharp csharpGenerator(irCode);
+        GeneratorCSharp csharpGenerator(irModule);
         csharpGenerator.genCode();
       }
       break;
     case LANG_JAVA:
       {
-        GeneratorJava javaGenerator(irCode);
+        GeneratorJava javaGenerator(irModule);
         javaGenerator.genCode();
       }
       break;
     case LANG_LUA:
       {
-        GeneratorLua luaGenerator(irCode);
+        GeneratorLua luaGenerator(irModule);
         luaGenerator.genCode();
       }
       break;
     case LANG_PYTHON:
       {
-        GeneratorPython pythonGenerator(irCode);
+        GeneratorPython pythonGenerator(irModule);
         pythonGenerator.genCode();
       }
       break;
     case LANG_RUBY:
       {
-        GeneratorRuby rubyGenerator(irCode);
+        GeneratorRuby rubyGenerator(irModule);
         rubyGenerator.genCode();
       }
       break;
@@ -278,12 +307,14 @@ Brainfuck::translate(LANG lang)
 void
 Brainfuck::generateWinBinary(BinType wbt)
 {
-  irCompiler.compile();
-  BfIR irCode = irCompiler.getCode();
+  if (irCompiler.getModule().empty()) {
+    normalCompile();
+  }
+  const BfIRModule &irModule = irCompiler.getModule();
   switch (wbt) {
     case WIN_BIN_X86:
       {
-        GeneratorWinX86 g = GeneratorWinX86(irCode);
+        GeneratorWinX86 g(irModule);
         g.genCode();
         binCodeSize = g.getSize();
 #if __cplusplus >= 201103L
@@ -297,7 +328,7 @@ Brainfuck::generateWinBinary(BinType wbt)
       break;
     case ELF_BIN_X64:
       {
-        GeneratorElfX64 g = GeneratorElfX64(irCode);
+        GeneratorElfX64 g(irModule, memorySize);
         g.genCode();
         binCodeSize = g.getSize();
 #if __cplusplus >= 201103L
@@ -318,84 +349,180 @@ Brainfuck::generateWinBinary(BinType wbt)
 /* ========================================================================= *
  * Private members                                                           *
  * ========================================================================= */
+/*!
+ * @brief Compile brainfuck source code into Brainfuck-IR
+ * @param [in] isChecked    If true, the bounds check of the tape is inserted
+ * @param [in] isInProcess  If true, the code is compiled for the engines
+ *                          which run it on BfTape in this process, so that
+ *                          the pointer movement is limited and the prefix
+ *                          of the code is evaluated
+ */
 void
-Brainfuck::normalCompile(void)
+Brainfuck::normalCompile(bool isChecked, bool isInProcess)
 {
+  irCompiler.setBoundsCheck(isChecked);
+  irCompiler.setOffsetLimit(isInProcess);
+  irCompiler.setPrefixEvaluation(isInProcess);
+  irCompiler.setMemorySize(memorySize);
+  if (sourceBuffer != nullptr) {
 #if __cplusplus >= 201103L
-  irCompiler.setSource(sourceBuffer.get());
+    irCompiler.setSource(sourceBuffer.get());
 #else
-  irCompiler.setSource(sourceBuffer);
+    irCompiler.setSource(sourceBuffer);
 #endif  // __cplusplus >= 201103L
-  irCompiler.compile();
+    irCompiler.compile();
+  } else {
+    // Compile the loaded source without trimming it
+    irCompiler.reset();
+    std::size_t blockSize;
+    for (const char *block; (block = sourceFile.readBlock(blockSize)) != nullptr;) {
+      irCompiler.feed(block, blockSize);
+    }
+    irCompiler.finish();
+    sourceFile.close();
+  }
   compileType = NORMAL_COMPILE;
 }
 
 
+/*!
+ * @brief Compile brainfuck source code into compact bytecode
+ */
+void
+Brainfuck::bytecodeCompile(void)
+{
+  normalCompile(safeMode, true);
+  bytecode.encode(irCompiler.getCode());
+  switch (cellSize) {
+    case 2:
+      bytecodeExecutor = selectBytecodeExecutor<unsigned short>(safeMode);
+      break;
+    case 4:
+      bytecodeExecutor = selectBytecodeExecutor<unsigned int>(safeMode);
+      break;
+    default:
+      bytecodeExecutor = selectBytecodeExecutor<unsigned char>(safeMode);
+      break;
+  }
+}
+
+
+/*!
+ * @brief Compile brainfuck source code into direct-threaded code
+ */
+void
+Brainfuck::threadedCompile(void)
+{
+  normalCompile(false, true);
+  threadedCompiler.setIRModule(irCompiler.getModule());
+  threadedCompiler.compile();
+  compileType = THREADED_COMPILE;
+}
+
+
+/*!
+ * @brief Build the table of the matching brackets for interpretExecute()
+ *
+ * Unmatched brackets are not an error until the interpreter jumps from them.
+ * @param [in] source  Trimmed source code
+ */
+void
+Brainfuck::matchBrackets(const std::vector<char> &source)
+{
+  std::vector<std::size_t>(source.size(), UNMATCHED_BRACKET).swap(bracketTable);
+  std::stack<std::size_t> loopStack;
+  for (std::size_t i = 0; i < source.size(); i++) {
+    if (source[i] == '[') {
+      loopStack.push(i);
+    } else if (source[i] == ']' && !loopStack.empty()) {
+      bracketTable[i] = loopStack.top();
+      bracketTable[loopStack.top()] = i;
+      loopStack.pop();
+    }
+  }
+}
+
+
 /*!
  * @brief Execute brainfuck without compile.
+ *
+ * Jumps of the loops go through the bracket table, which is built by trim().
  */
 void
 Brainfuck::interpretExecute(void) const
 {
+  BfTape tape(memorySize);
+  tape.setIO(io);
+  unsigned char* ptr = tape.get();
 #if __cplusplus >= 201103L
-  std::unique_ptr<unsigned char[]> memory(new unsigned char[memorySize]);
-  unsigned char* ptr = memory.get();
+  const char *source = sourceBuffer.get();
 #else
-  unsigned char* memory = new unsigned char[memorySize];
-  unsigned char* ptr = memory;
-#endif
-  std::fill_n(ptr, memorySize, 0);
-#if __cplusplus >= 201103L
-  for (const char *srcptr = sourceBuffer.get(); *srcptr != '\0'; srcptr++) {
-#else
-  for (const char *srcptr = sourceBuffer; *srcptr != '\0'; srcptr++) {
+  const char *source = sourceBuffer;
 #endif
+  for (const char *srcptr = source; *srcptr != '\0'; srcptr++) {
     switch (*srcptr) {
       case '>': ptr++;    break;
       case '<': ptr--;    break;
       case '+': (*ptr)++; break;
       case '-': (*ptr)--; break;
       case '.':
-        std::cout.put(static_cast<char>(*ptr));
+        io->put(*ptr);
         break;
       case ',':
-        *ptr = static_cast<unsigned char>(std::cin.get());
+        *ptr = static_cast<unsigned char>(io->get());
         break;
       case '[':
         if (*ptr != 0) break;
-        srcptr = findLoopEnd(srcptr);
+        if (bracketTable[srcptr - source] == UNMATCHED_BRACKET) {
+          throw std::runtime_error("Parse error: cannot find the end of loop");
+        }
+        srcptr = source + bracketTable[srcptr - source];
         break;
       case ']':
         if (*ptr == 0) break;
-        srcptr = findLoopStart(srcptr);
+        if (bracketTable[srcptr - source] == UNMATCHED_BRACKET) {
+          throw std::runtime_error("Parse error: cannot find the start of loop");
+        }
+        srcptr = source + bracketTable[srcptr - source];
         break;
     }
   }
-#if __cplusplus < 201103L
-  delete[] memory;
-#endif  // __cplusplus < 201103L
 }
 
 
 /*!
- * @brief Execute compiled brainfuck source code
+ * @brief Execute compiled brainfuck bytecode
+ *
+ * Bytecode is executed by the engine which is selected by bytecodeCompile().
  */
 void
 Brainfuck::compileExecute(void) const
 {
-#if __cplusplus >= 201103L
-  std::unique_ptr<unsigned char[]> memory(new unsigned char[memorySize]);
-  unsigned char* ptr = memory.get();
-#else
-  unsigned char* memory = new unsigned char[memorySize];
-  unsigned char* ptr = memory;
-#endif
-  std::fill_n(ptr, memorySize, 0);
+  (this->*bytecodeExecutor)();
+}
+
 
-  BfIR irCode = irCompiler.getCode();
-  BfIR::size_type size = irCompiler.getSize();
-  for (unsigned int pc = 0; pc < size; pc++) {
-    switch (irCode[pc].type) {
+/*!
+ * @brief Execute compiled brainfuck bytecode on the specialized engine
+ * @tparam CellT         Type of the cell: unsigned char, unsigned short or
+ *                       unsigned int
+ * @tparam IoPolicy      Policy which reads and writes the cells
+ * @tparam BoundsPolicy  Policy which executes CHECK instructions
+ */
+template<typename CellT, class IoPolicy, class BoundsPolicy>
+void
+Brainfuck::executeBytecode(void) const
+{
+  // The checked code stops with an error instead of growing the tape
+  BfTape tape(memorySize * sizeof(CellT), safeMode ? 0 : BfTape::DEFAULT_RESERVE_SIZE);
+  tape.setIO(io);
+  CellT *ptr = reinterpret_cast<CellT *>(tape.get());
+  IoPolicy ioPolicy(*io);
+  BoundsPolicy bounds(ptr, memorySize);
+  const BfStringPool &strings = irCompiler.getModule().getStrings();
+
+  for (const unsigned char *ip = bytecode.begin(), *end = bytecode.end(); ip != end;) {
+    switch (static_cast<BfInstruction::Instruction>(*ip++)) {
       case BfInstruction::NEXT:
         ptr++;
         break;
@@ -403,10 +530,10 @@ Brainfuck::compileExecute(void) const
         ptr--;
         break;
       case BfInstruction::NEXT_N:
-        ptr += irCode[pc].value1;
+        ptr += BfBytecode::readOperand(ip);
         break;
       case BfInstruction::PREV_N:
-        ptr -= irCode[pc].value1;
+        ptr -= BfBytecode::readOperand(ip);
         break;
       case BfInstruction::INC:
         (*ptr)++;
@@ -415,92 +542,161 @@ Brainfuck::compileExecute(void) const
         (*ptr)--;
         break;
       case BfInstruction::ADD:
-        *ptr += irCode[pc].value1;
+        *ptr = static_cast<CellT>(*ptr + BfBytecode::readOperand(ip));
         break;
       case BfInstruction::SUB:
-        *ptr -= irCode[pc].value1;
+        *ptr = static_cast<CellT>(*ptr - BfBytecode::readOperand(ip));
         break;
       case BfInstruction::INC_AT:
-        (*(ptr + irCode[pc].value1))++;
+        (*(ptr + BfBytecode::readOperand(ip)))++;
         break;
       case BfInstruction::DEC_AT:
-        (*(ptr + irCode[pc].value1))--;
+        (*(ptr + BfBytecode::readOperand(ip)))--;
         break;
       case BfInstruction::ADD_AT:
-        *(ptr + irCode[pc].value1) += static_cast<unsigned char>(irCode[pc].value2);
+        {
+          CellT *p = ptr + BfBytecode::readOperand(ip);
+          *p = static_cast<CellT>(*p + BfBytecode::readOperand(ip));
+        }
         break;
       case BfInstruction::SUB_AT:
-        *(ptr + irCode[pc].value1) -= static_cast<unsigned char>(irCode[pc].value2);
+        {
+          CellT *p = ptr + BfBytecode::readOperand(ip);
+          *p = static_cast<CellT>(*p - BfBytecode::readOperand(ip));
+        }
         break;
       case BfInstruction::PUTCHAR:
-        std::cout.put(static_cast<char>(*ptr));
+        ioPolicy.put(ptr[BfBytecode::readOperand(ip)]);
         break;
       case BfInstruction::GETCHAR:
-        *ptr = static_cast<unsigned char>(std::cin.get());
+        ptr[BfBytecode::readOperand(ip)] = ioPolicy.template get<CellT>();
         break;
       case BfInstruction::LOOP_START:
-        if (*ptr == 0) {
-          pc = irCode[pc].value1;
+        {
+          int offset = BfBytecode::readJump(ip);
+          if (*ptr == 0) {
+            ip += offset;
+          }
         }
         break;
       case BfInstruction::LOOP_END:
-        if (*ptr != 0) {
-          pc = irCode[pc].value1;
+        {
+          int offset = BfBytecode::readJump(ip);
+          if (*ptr != 0) {
+            ip += offset;
+          }
+        }
+        break;
+      case BfInstruction::IF:
+        {
+          int offset = BfBytecode::readJump(ip);
+          if (*ptr == 0) {
+            ip += offset;
+          }
         }
         break;
+      case BfInstruction::END_IF:
+        break;
       case BfInstruction::ASSIGN_ZERO:
         *ptr = 0;
         break;
       case BfInstruction::ASSIGN:
-        *ptr = static_cast<unsigned char>(irCode[pc].value1);
+        *ptr = static_cast<CellT>(BfBytecode::readOperand(ip));
         break;
       case BfInstruction::ASSIGN_AT:
-        *(ptr + irCode[pc].value1) = static_cast<unsigned char>(irCode[pc].value2);
-        break;
-      case BfInstruction::SEARCH_ZERO:
         {
-          int offset = irCode[pc].value1;
-          while (*ptr) {
-            ptr += offset;
-          }
+          CellT *p = ptr + BfBytecode::readOperand(ip);
+          *p = static_cast<CellT>(BfBytecode::readOperand(ip));
         }
         break;
+      case BfInstruction::SEARCH_ZERO:
+        ptr = BfSimd::searchZero(ptr, BfBytecode::readOperand(ip));
+        break;
       case BfInstruction::ADD_VAR:
-        if (*ptr) {
-          *(ptr + irCode[pc].value1) += *ptr;
+        {
+          CellT *p = ptr + BfBytecode::readOperand(ip);
+          *p = static_cast<CellT>(*p + *ptr);
           *ptr = 0;
         }
         break;
       case BfInstruction::SUB_VAR:
-        /*
-         * Following code is slower. But I Don't know why.
-         *   if (*ptr) {
-         *     *(ptr + static_cast<int>(irCode[pc].value1)) -= *ptr;
-         *     *ptr = 0;
-         *   }
-         */
-        while (*ptr) {
-          (*ptr)--;
-          ptr += static_cast<unsigned char>(irCode[pc].value1);
-          (*ptr)--;
-          ptr -= static_cast<unsigned char>(irCode[pc].value1);
+        {
+          CellT *p = ptr + BfBytecode::readOperand(ip);
+          *p = static_cast<CellT>(*p - *ptr);
+          *ptr = 0;
         }
         break;
       case BfInstruction::CMUL_VAR:
-        if (*ptr) {
-          *(ptr + irCode[pc].value1) += *ptr * irCode[pc].value2;
+        {
+          CellT *p = ptr + BfBytecode::readOperand(ip);
+          *p = static_cast<CellT>(*p + *ptr * BfBytecode::readOperand(ip));
+          *ptr = 0;
+        }
+        break;
+      case BfInstruction::MULTI_CMUL_VAR:
+        {
+          int n = BfBytecode::readOperand(ip);
+          for (int i = 0; i < n; i++) {
+            ip++;  // Skip CMUL_TARGET
+            CellT *p = ptr + BfBytecode::readOperand(ip);
+            *p = static_cast<CellT>(*p + *ptr * BfBytecode::readOperand(ip));
+          }
           *ptr = 0;
         }
         break;
+      case BfInstruction::CMUL_TARGET:
+        // Always consumed by MULTI_CMUL_VAR
+        BfBytecode::readOperand(ip);
+        BfBytecode::readOperand(ip);
+        break;
       case BfInstruction::INF_LOOP:
         if (*ptr) {
           for (;;);
         }
+        break;
+      case BfInstruction::CHECK:
+        {
+          int minOffset = BfBytecode::readOperand(ip);
+          int maxOffset = BfBytecode::readOperand(ip);
+          bounds.check(ptr, minOffset, maxOffset);
+        }
+        break;
+      case BfInstruction::PUTS:
+        ioPolicy.write(strings[static_cast<BfStringPool::size_type>(BfBytecode::readOperand(ip))]);
+        BfBytecode::readOperand(ip);  // Skip the offset of the scratch cell
+        break;
     }
   }
-#if __cplusplus < 201103L
-  delete[] memory;
-#endif  // __cplusplus < 201103L
+}
+
+
+/*!
+ * @brief Select the bytecode engine for the type of the cell
+ * @tparam CellT  Type of the cell
+ * @param [in] isChecked  If true, CHECK instructions are executed
+ * @return Bytecode engine
+ */
+template<typename CellT>
+Brainfuck::BytecodeExecutor
+Brainfuck::selectBytecodeExecutor(bool isChecked)
+{
+  if (isChecked) {
+    return &Brainfuck::executeBytecode<CellT, BfIOPolicy, BfCheckedBounds>;
+  } else {
+    return &Brainfuck::executeBytecode<CellT, BfIOPolicy, BfUncheckedBounds>;
+  }
+}
+
+
+/*!
+ * @brief Execute direct-threaded code
+ */
+void
+Brainfuck::threadedExecute(void) const
+{
+  BfTape tape(memorySize);
+  tape.setIO(io);
+  threadedCompiler.execute(tape.get(), *io);
 }
 
 
@@ -511,10 +707,18 @@ Brainfuck::compileExecute(void) const
 void
 Brainfuck::xbyakJitCompile(void)
 {
-  normalCompile();
-  BfIR irCode = irCompiler.getCode();
-  jitCompiler.setIRCode(irCode);
-  jitCompiler.compile();
+  normalCompile(safeMode, true);
+  const BfIRModule &irModule = irCompiler.getModule();
+  std::size_t size = BfJitCompiler::estimateCodeSize(irModule);
+#if __cplusplus >= 201103L
+  jitCompiler.reset(new BfJitCompiler(irModule, size));
+#else
+  delete jitCompiler;
+  jitCompiler = new BfJitCompiler(irModule, size);
+#endif  // __cplusplus >= 201103L
+  jitCompiler->setCellSize(cellSize);
+  jitCompiler->setMemorySize(memorySize);
+  jitCompiler->compile();
   compileType = XBYAK_JIT_COMPILE;
 }
 
@@ -525,18 +729,16 @@ Brainfuck::xbyakJitCompile(void)
 void
 Brainfuck::xbyakJitExecute(void)
 {
-#if __cplusplus >= 201103L
-  std::unique_ptr<int[]> xbyakRtStack(new int[xbyakRtStackSize]);
-  std::fill_n(xbyakRtStack.get(), xbyakRtStackSize, 0);
-  jitCompiler.getCode<void (*)(int (*)(int), int (*)(), int *)>()
-    (std::putchar, std::getchar, xbyakRtStack.get());
-#else
-  int* xbyakRtStack = new int[xbyakRtStackSize];
-  std::fill_n(xbyakRtStack, xbyakRtStackSize, 0);
-  jitCompiler.getCode<void (*)(int (*)(int), int (*)(), int *)>()
-    (std::putchar, std::getchar, xbyakRtStack);
-  delete[] xbyakRtStack;
-#endif  // __cplusplus >= 201103L
+  BfTape tape(memorySize * static_cast<std::size_t>(cellSize), safeMode ? 0 : BfTape::DEFAULT_RESERVE_SIZE);
+  tape.setIO(io);
+  tape.setFaultHook(flushJitOutputOnFault);
+  jitIO = io;
+  int status = jitCompiler->getCode<int (*)(void (*)(const unsigned char *, std::size_t), int (*)(), void *, unsigned char **)>()
+    (flushJitOutput, readJitInput, tape.get(), &jitFrame);
+  jitFrame = nullptr;
+  if (status != 0) {
+    throw std::runtime_error("Tape overflow: the pointer is out of the tape");
+  }
 }
 #endif  // USE_XBYAK
 
@@ -549,42 +751,42 @@ Brainfuck::xbyakJitExecute(void)
 /* ========================================================================= *
  * Local functions                                                           *
  * ========================================================================= */
+#ifdef USE_XBYAK
 /*!
- * @brief Find the end of loop
- * @param [in] code  Pointer to the brainfuck source code
- * @return  Pointer to the end of loop of brainfuck source code
+ * @brief Pass the output buffer of JIT-compiled code to the I/O
+ * @param [in] buf   Output buffer
+ * @param [in] size  The number of bytes in the buffer
  */
-static const char *
-findLoopEnd(const char *srcptr)
+static void
+flushJitOutput(const unsigned char *buf, std::size_t size)
 {
-  char ch;
-  int depth = 1;
-  while (ch = *++srcptr, depth > 0) {
-    switch (ch) {
-      case '[':  depth++; break;
-      case ']':  depth--; break;
-      case '\0': throw std::runtime_error("Parse error: cannod find the end of loop");
-    }
-  }
-  return srcptr - 1;
+  jitIO->write(buf, size);
 }
 
 
 /*!
- * @brief Find the start of loop
- * @param [in] code  Pointer to the brainfuck source code
- * @return  Pointer to the start of loop of brainfuck source code
+ * @brief Read one byte for JIT-compiled code
+ * @return Byte which is read, or EOF
  */
-static const char *
-findLoopStart(const char *srcptr)
+static int
+readJitInput(void)
 {
-  char ch;
-  int depth = 1;
-  while (ch = *--srcptr, depth > 0) {
-    switch (ch) {
-      case '[': depth--; break;
-      case ']': depth++; break;
-    }
+  return jitIO->get();
+}
+
+
+/*!
+ * @brief Write the output which is buffered by JIT-compiled code on the tape
+ *        overflow
+ * @param [in,out] io  I/O of the engine
+ */
+static void
+flushJitOutputOnFault(bf::BfIO *io)
+{
+  if (jitFrame != nullptr) {
+    std::size_t size;
+    const unsigned char *output = bf::BfJitCompiler::getBufferedOutput(jitFrame, size);
+    io->writeOnFault(output, size);
   }
-  return srcptr;
 }
+#endif  // USE_XBYAK
@@ -13,8 +13,12 @@
 #  include <xbyak/xbyak.h>
 #endif  // USE_XBYAK
 
+#include "BfBytecode.h"
+#include "BfIO.h"
 #include "BfIRCompiler.h"
+#include "BfSourceFile.h"
 #include "BfJitCompiler.h"
+#include "BfThreadedCompiler.h"
 #include "CodeGenerator/CodeGenerator.h"
 #include "compat.h"
 
@@ -25,7 +29,7 @@ namespace bf {
 class Brainfuck {
 public:
   typedef enum {
-    NO_COMPILE, NORMAL_COMPILE
+    NO_COMPILE, NORMAL_COMPILE, THREADED_COMPILE
 #ifdef USE_XBYAK
     , XBYAK_JIT_COMPILE
 #endif  // USE_XBYAK
@@ -46,15 +50,23 @@ public:
     ELF_BIN_X64
   } BinType;
 
-  Brainfuck(std::size_t memorySize=65536) :
+  Brainfuck(std::size_t memorySize=65536, int cellSize=1) :
     memorySize(memorySize),
+    cellSize(cellSize),
     binCodeSize(0),
     compileType(NO_COMPILE),
+    safeMode(false),
+    sourceFile(),
     sourceBuffer(nullptr),
-    binCode(nullptr)
-#ifdef USE_XBYAK
-    , xbyakRtStackSize(XBYAK_RT_STACK_SIZE)
-#endif  // USE_XBYAK
+    binCode(nullptr),
+    bracketTable(),
+    irCompiler(),
+    bytecode(),
+    bytecodeExecutor(nullptr),
+    jitCompiler(nullptr),
+    threadedCompiler(),
+    stdIO(),
+    io(&stdIO)
     {}
 #if __cplusplus < 201103L
   ~Brainfuck(void);
@@ -65,6 +77,22 @@ public:
   void compile(CompileType compileType=NORMAL_COMPILE);
   void execute(void);
   void translate(LANG lang=LANG_C);
+  /*!
+   * @brief Set the I/O which is used by execute()
+   *
+   * io must outlive this instance; stdin and stdout are used by default.
+   * @param [in,out] io  I/O
+   */
+  void setIO(BfIO &io) { this->io = &io; }
+  /*!
+   * @brief Enable or disable the bounds check of the tape
+   *
+   * The checked code runs on the tape which doesn't grow, and stops with an
+   * error on overflow.
+   * It takes effect only on NORMAL_COMPILE and XBYAK_JIT_COMPILE.
+   * @param [in] safeMode  If true, the code is compiled with bounds checks
+   */
+  void setSafeMode(bool safeMode) { this->safeMode = safeMode; }
   void generateWinBinary(BinType wbt=WIN_BIN_X86);
   inline const unsigned char *getWinBinary(void) const;
   inline std::size_t getWinBinarySize(void) const;
@@ -73,9 +101,15 @@ public:
 #endif  // USE_XBYAK
 
 private:
+  //! Bytecode engine which is specialized on the cell, I/O and bounds check
+  typedef void (Brainfuck::*BytecodeExecutor)(void) const;
+
   std::size_t memorySize;
+  int cellSize;
   std::size_t binCodeSize;
   CompileType compileType;
+  bool safeMode;
+  BfSourceFile sourceFile;
 #if __cplusplus >= 201103L
   std::unique_ptr<char[]> sourceBuffer;
   std::unique_ptr<unsigned char[]> binCode;
@@ -83,17 +117,36 @@ private:
   char* sourceBuffer;
   unsigned char* binCode;
 #endif  // __cplusplus >= 201103L
+  std::vector<std::size_t> bracketTable;
   BfIRCompiler  irCompiler;
-  BfJitCompiler jitCompiler;
-#ifdef USE_XBYAK
-  static const unsigned int XBYAK_RT_STACK_SIZE = 128 * 1024;
-  std::size_t xbyakRtStackSize;
-#endif  // USE_XBYAK
+  BfBytecode    bytecode;
+  BytecodeExecutor bytecodeExecutor;
+#if __cplusplus >= 201103L
+  std::unique_ptr<BfJitCompiler> jitCompiler;
+#else
+  BfJitCompiler* jitCompiler;
+#endif  // __cplusplus >= 201103L
+  BfThreadedCompiler threadedCompiler;
+  BfFdIO stdIO;
+  BfIO *io;
+
+  static const std::size_t UNMATCHED_BRACKET = static_cast<std::size_t>(-1);
+
+  Brainfuck(const Brainfuck &);
+  Brainfuck &operator=(const Brainfuck &);
 
-  void normalCompile(void);
+  void matchBrackets(const std::vector<char> &source);
+  void normalCompile(bool isChecked=false, bool isInProcess=false);
+  void bytecodeCompile(void);
+  void threadedCompile(void);
   void interpretExecute(void) const;
   void compileExecute(void) const;
+  void threadedExecute(void) const;
 
+  template<typename CellT, class IoPolicy, class BoundsPolicy>
+    void executeBytecode(void) const;
+  template<typename CellT>
+    static BytecodeExecutor selectBytecodeExecutor(bool isChecked);
   template<class TCodeGenerator>
     void generateCode(TCodeGenerator& cg);
 #ifdef USE_XBYAK
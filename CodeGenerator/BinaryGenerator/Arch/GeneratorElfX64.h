@@ -2,6 +2,8 @@
 #define GENERATOR_ELF_X64
 
 
+#include <algorithm>
+#include <string>
 #include "../BinaryGenerator.h"
 #include "elfsubset.h"
 
@@ -13,6 +15,16 @@ class GeneratorElfX64 : public BinaryGenerator {
 private:
   static const unsigned int HEADER_SIZE = sizeof(Elf64_Ehdr) + sizeof(Elf64_Phdr) * 2;
   static const unsigned int ADDR = 0x08048000;
+  static const unsigned int ADDR_BSS = ADDR + 0x200000;
+  static const unsigned int OUTPUT_BUFFER_SIZE = 4096;
+  static const unsigned int INPUT_BUFFER_SIZE = 4096;
+  static const unsigned int ADDR_OUTPUT_BUFFER = ADDR_BSS;
+  static const unsigned int ADDR_INPUT_BUFFER = ADDR_OUTPUT_BUFFER + OUTPUT_BUFFER_SIZE;
+  static const unsigned int ADDR_TAPE = ADDR_INPUT_BUFFER + INPUT_BUFFER_SIZE;
+  static const unsigned int PUTS_CHUNK_SIZE = 256;
+  std::size_t memorySize;
+  std::size_t flushRoutine;
+  std::size_t getcharRoutine;
   inline void genPlorogue(void);
   inline void genEpirogue(void);
   inline void genHeader(void);
@@ -21,41 +33,88 @@ private:
   inline void genPrevN(int value);
   inline void genAdd(int value);
   inline void genSub(int value);
+  inline void genAddAt(int value1, int value2);
+  inline void genSubAt(int value1, int value2);
   inline void genPutchar(void);
   inline void genGetchar(void);
+  inline void genPutcharAt(int value);
+  inline void genGetcharAt(int value);
   inline void genLoopStart(void);
   inline void genLoopEnd(void);
+  inline void genAssign(int value);
+  inline void genAssignAt(int value1, int value2);
+  inline void genSearchZero(int value);
+  inline void genAddVar(int value);
+  inline void genSubVar(int value);
+  inline void genCmulVar(int value1, int value2);
+  inline void genMultiCmulStart(int value);
+  inline void genMultiCmulTarget(int value1, int value2);
+  inline void genMultiCmulEnd(void);
+  inline void genInfLoop(void);
+  inline void genPuts(const std::string &str, int value);
+  inline void genIf(void);
+  inline void genEndIf(void);
+  inline void genCellOperand(int reg, int offset);
+  inline void genAddImm(int value);
+  inline void genFlushRoutine(void);
+  inline void genGetcharRoutine(void);
+  inline void genCall(std::size_t target);
+  inline std::size_t getBssSize(void) const;
 public:
-  GeneratorElfX64(BfIR irCode, std::size_t codeSize=DEFAULT_MAX_CODE_SIZE) :
-    BinaryGenerator(irCode) {}
+  GeneratorElfX64(const BfIRModule &irModule, std::size_t memorySize=65536, std::size_t codeSize=DEFAULT_CODE_SIZE) :
+    BinaryGenerator(irModule, codeSize),
+    memorySize(memorySize),
+    flushRoutine(0),
+    getcharRoutine(0)
+  {}
 };
 
 
 
 
+/*!
+ * @brief Generate the start-up code and the I/O runtime
+ *
+ * Registers are used as follows.
+ * - rbx: Pointer to the current cell
+ * - r12: Write position of the output buffer
+ * - r13: Read position of the input buffer
+ * - r14: End of the data in the input buffer
+ * The runtime routines are placed before the main code, so that calls to
+ * them can be resolved on emission.
+ */
 inline void
 GeneratorElfX64::genPlorogue(void)
 {
-  codePtr += HEADER_SIZE;
-  *codePtr++ = 0x48; *codePtr++ = 0xbb;
-  *reinterpret_cast<uint64_t *>(codePtr) = ADDR + 0x200000; codePtr += sizeof(uint64_t);
+  emitZeros(HEADER_SIZE);
+  emitByte(0xbb); emitDword(ADDR_TAPE);  // mov ebx, ADDR_TAPE
+  emitByte(0x41); emitByte(0xbc); emitDword(ADDR_OUTPUT_BUFFER);  // mov r12d, ADDR_OUTPUT_BUFFER
+  emitByte(0x41); emitByte(0xbd); emitDword(ADDR_INPUT_BUFFER);  // mov r13d, ADDR_INPUT_BUFFER
+  emitByte(0x4d); emitByte(0x89); emitByte(0xee);  // mov r14, r13
+  emitByte(0xe9);  // jmp rel32 (patched below)
+  std::size_t mainRel = getOffset();
+  emitDword(0x00000000);
+  genFlushRoutine();
+  genGetcharRoutine();
+  patchDword(mainRel, getRelative(getOffset(), mainRel + sizeof(int32_t)));
 }
 
 
 inline void
 GeneratorElfX64::genEpirogue(void)
 {
-  *codePtr++ = 0xb8; *codePtr++ = 0x3c; *codePtr++ = 0x00; *codePtr++ = 0x00; *codePtr++ = 0x00;
-  *codePtr++ = 0xbf; *codePtr++ = 0x2a; *codePtr++ = 0x00; *codePtr++ = 0x00; *codePtr++ = 0x00;
-  *codePtr++ = 0x0f; *codePtr++ = 0x05;
-  codeSize = codePtr - (code + HEADER_SIZE);
+  genCall(flushRoutine);
+  emitByte(0xb8); emitByte(0x3c); emitByte(0x00); emitByte(0x00); emitByte(0x00);
+  emitByte(0xbf); emitByte(0x2a); emitByte(0x00); emitByte(0x00); emitByte(0x00);
+  emitByte(0x0f); emitByte(0x05);
+  codeSize = getOffset() - HEADER_SIZE;
 }
 
 
 inline void
 GeneratorElfX64::genHeader(void)
 {
-  unsigned char *ptr = code;
+  unsigned char *ptr = getPointer(0, HEADER_SIZE);
 
   // ELF header
   Elf64_Ehdr *ehdr = reinterpret_cast<Elf64_Ehdr *>(ptr);
@@ -104,7 +163,7 @@ GeneratorElfX64::genHeader(void)
   phdr->p_vaddr = ADDR + 0x200000;
   phdr->p_paddr = ADDR + 0x200000;
   phdr->p_filesz = 0x0000000000000000;
-  phdr->p_memsz = 0x0000000000007530;
+  phdr->p_memsz = getBssSize();
   phdr->p_align = 0x0000000000200000;
   ptr += sizeof(Elf64_Phdr);
 }
@@ -114,7 +173,9 @@ inline void
 GeneratorElfX64::genFooter(void)
 {
   static const char SHSTRTBL[] = "\0.text\0.shstrtbl\0.bss";
-  unsigned char *ptr = codePtr;
+  std::size_t offset = getOffset();
+  emitZeros(sizeof(SHSTRTBL) + sizeof(Elf64_Shdr) * 4);
+  unsigned char *ptr = getPointer(offset, sizeof(SHSTRTBL) + sizeof(Elf64_Shdr) * 4);
 
   // section string table (22bytes)
   std::memcpy(ptr, SHSTRTBL, sizeof(SHSTRTBL));
@@ -170,94 +231,397 @@ GeneratorElfX64::genFooter(void)
   shdr->sh_flags = SHF_ALLOC | SHF_WRITE;
   shdr->sh_addr = ADDR + 0x200000;
   shdr->sh_offset = 0x0000000000001000;
-  shdr->sh_size = 0x0000000000007530;
+  shdr->sh_size = getBssSize();
   shdr->sh_link = 0x00000000;
   shdr->sh_info = 0x00000000;
   shdr->sh_addralign = 0x0000000000000010;
   shdr->sh_entsize = 0x0000000000000000;
   ptr += sizeof(Elf64_Shdr);
 
-  codePtr = ptr;
-  binSize = codePtr - code;
+  binSize = getOffset();
 }
 
 
 inline void
 GeneratorElfX64::genNextN(int value)
 {
-  for (int i = 0; i < value; i++) {
-    *codePtr++ = 0x48; *codePtr++ = 0xff; *codePtr++ = 0xc3;  // inc rbx
-  }
+  genAddImm(value);
 }
 
 
 inline void
 GeneratorElfX64::genPrevN(int value)
 {
-  for (int i = 0; i < value; i++) {
-    *codePtr++ = 0x48; *codePtr++ = 0xff; *codePtr++ = 0xcb;  // dec rbx
-  }
+  genAddImm(-value);
 }
 
 
 inline void
 GeneratorElfX64::genAdd(int value)
 {
-  for (int i = 0; i < value; i++) {
-    *codePtr++ = 0xfe; *codePtr++ = 0x03;  // inc byte ptr [rbx]
-  }
+  genAddAt(0, value);
 }
 
 
 inline void
 GeneratorElfX64::genSub(int value)
 {
-  for (int i = 0; i < value; i++) {
-    *codePtr++ = 0xfe; *codePtr++ = 0x0b;  // dec byte ptr [rbx]
+  genSubAt(0, value);
+}
+
+
+inline void
+GeneratorElfX64::genAddAt(int value1, int value2)
+{
+  unsigned char imm = static_cast<unsigned char>(value2);
+  if (imm == 0x00) {
+    return;
+  } else if (imm == 0x01) {
+    emitByte(0xfe); genCellOperand(0, value1);  // inc byte ptr [rbx + value1]
+  } else if (imm == 0xff) {
+    emitByte(0xfe); genCellOperand(1, value1);  // dec byte ptr [rbx + value1]
+  } else {
+    emitByte(0x80); genCellOperand(0, value1); emitByte(imm);  // add byte ptr [rbx + value1], imm8
   }
 }
 
 
+inline void
+GeneratorElfX64::genSubAt(int value1, int value2)
+{
+  genAddAt(value1, -value2);
+}
+
+
 inline void
 GeneratorElfX64::genPutchar(void)
 {
-  *codePtr++ = 0x48; *codePtr++ = 0xc7; *codePtr++ = 0xc0; *codePtr++ = 0x01; *codePtr++ = 0x00; *codePtr++ = 0x00; *codePtr++ = 0x00;  // mov rax, 1 (set system call to write)
-  *codePtr++ = 0xba; *codePtr++ = 0x01; *codePtr++ = 0x00; *codePtr++ = 0x00; *codePtr++ = 0x00;  // mov edx, 0x01 (3rd argument)
-  *codePtr++ = 0x48; *codePtr++ = 0x89; *codePtr++ = 0xde;  // mov rsi, rbx (2nd argument)
-  *codePtr++ = 0xbf; *codePtr++ = 0x01; *codePtr++ = 0x00; *codePtr++ = 0x00; *codePtr++ = 0x00;  // mov edi, 0x1 (1st argument)
-  *codePtr++ = 0x0f; *codePtr++ = 0x05;  // syscall
+  genPutcharAt(0);
 }
 
 
 inline void
 GeneratorElfX64::genGetchar(void)
 {
-  *codePtr++ = 0x48; *codePtr++ = 0xc7; *codePtr++ = 0xc0; *codePtr++ = 0x00; *codePtr++ = 0x00; *codePtr++ = 0x00; *codePtr++ = 0x00;  // mov rax, 0 (set system call to write)
-  *codePtr++ = 0xba; *codePtr++ = 0x01; *codePtr++ = 0x00; *codePtr++ = 0x00; *codePtr++ = 0x00;  // mov edx, 0x01 (3rd argument)
-  *codePtr++ = 0x48; *codePtr++ = 0x89; *codePtr++ = 0xde;  // mov rsi, rbx (2nd argument)
-  *codePtr++ = 0xbf; *codePtr++ = 0x00; *codePtr++ = 0x00; *codePtr++ = 0x00; *codePtr++ = 0x00;  // mov edi, 0x0 (1st argument)
-  *codePtr++ = 0x0f; *codePtr++ = 0x05;  // syscall
+  genGetcharAt(0);
+}
+
+
+inline void
+GeneratorElfX64::genPutcharAt(int value)
+{
+  emitByte(0x8a); genCellOperand(0, value);  // mov al, byte ptr [rbx + value]
+  emitByte(0x41); emitByte(0x88); emitByte(0x04); emitByte(0x24);  // mov byte ptr [r12], al
+  emitByte(0x49); emitByte(0xff); emitByte(0xc4);  // inc r12
+  emitByte(0x49); emitByte(0x81); emitByte(0xfc); emitDword(ADDR_OUTPUT_BUFFER + OUTPUT_BUFFER_SIZE);  // cmp r12, ADDR_OUTPUT_BUFFER + OUTPUT_BUFFER_SIZE
+  emitByte(0x75); emitByte(0x05);  // jne +5
+  genCall(flushRoutine);
+}
+
+
+inline void
+GeneratorElfX64::genGetcharAt(int value)
+{
+  emitByte(0x48); emitByte(0x8d); genCellOperand(6, value);  // lea rsi, [rbx + value]
+  genCall(getcharRoutine);
 }
 
 
 inline void
 GeneratorElfX64::genLoopStart(void)
 {
-  loopStack.push(codePtr);
-  *codePtr++ = 0x80; *codePtr++ = 0x3b; *codePtr++ = 0x00;  // cmp byte ptr [rbx], 0
-  *codePtr++ = 0x0f; *codePtr++ = 0x84;
-  *reinterpret_cast<uint32_t *>(codePtr) = 0x00000000; codePtr += sizeof(uint32_t);
+  loopStack.push(getOffset());
+  emitByte(0x80); emitByte(0x3b); emitByte(0x00);  // cmp byte ptr [rbx], 0
+  emitByte(0x0f); emitByte(0x84);  // je (patched by genLoopEnd)
+  emitDword(0x00000000);
 }
 
 
 inline void
 GeneratorElfX64::genLoopEnd(void)
 {
-  unsigned char *_codePtr = loopStack.top();
+  std::size_t start = loopStack.top();
   loopStack.pop();
-  *codePtr++ = 0xe9;
-  *reinterpret_cast<int32_t *>(codePtr) = -static_cast<int32_t>(codePtr + sizeof(int32_t) - _codePtr); codePtr += sizeof(int32_t);
-  *reinterpret_cast<int32_t *>(_codePtr + 5) = static_cast<int32_t>(codePtr - (_codePtr + 9));
+  // Test the condition at the bottom of the loop and jump back to the top of the body
+  std::size_t body = start + 9;
+  emitByte(0x80); emitByte(0x3b); emitByte(0x00);  // cmp byte ptr [rbx], 0
+  int rel = getRelative(body, getOffset() + 2);
+  if (rel >= -128) {
+    emitByte(0x75); emitByte(rel);  // jne rel8
+  } else {
+    emitByte(0x0f); emitByte(0x85);  // jne rel32
+    emitDword(getRelative(body, getOffset() + sizeof(int32_t)));
+  }
+  patchDword(start + 5, getRelative(getOffset(), body));
+}
+
+
+inline void
+GeneratorElfX64::genAssign(int value)
+{
+  genAssignAt(0, value);
+}
+
+
+inline void
+GeneratorElfX64::genAssignAt(int value1, int value2)
+{
+  emitByte(0xc6); genCellOperand(0, value1); emitByte(static_cast<unsigned char>(value2));  // mov byte ptr [rbx + value1], imm8
+}
+
+
+inline void
+GeneratorElfX64::genSearchZero(int value)
+{
+  emitByte(0x80); emitByte(0x3b); emitByte(0x00);  // cmp byte ptr [rbx], 0
+  emitByte(0x74);  // je rel8 (patched below)
+  std::size_t exitRel = getOffset();
+  emitByte(0x00);
+  std::size_t top = getOffset();
+  genAddImm(value);
+  emitByte(0x80); emitByte(0x3b); emitByte(0x00);  // cmp byte ptr [rbx], 0
+  emitByte(0x75); emitByte(getRelative(top, getOffset() + 1));  // jne rel8
+  patchByte(exitRel, getRelative(getOffset(), exitRel + 1));
+}
+
+
+inline void
+GeneratorElfX64::genAddVar(int value)
+{
+  genCmulVar(value, 1);
+}
+
+
+inline void
+GeneratorElfX64::genSubVar(int value)
+{
+  genCmulVar(value, -1);
+}
+
+
+inline void
+GeneratorElfX64::genCmulVar(int value1, int value2)
+{
+  genMultiCmulStart(1);
+  genMultiCmulTarget(value1, value2);
+  genMultiCmulEnd();
+}
+
+
+inline void
+GeneratorElfX64::genMultiCmulStart(int)
+{
+  emitByte(0x0f); emitByte(0xb6); emitByte(0x03);  // movzx eax, byte ptr [rbx]
+}
+
+
+inline void
+GeneratorElfX64::genMultiCmulTarget(int value1, int value2)
+{
+  unsigned char factor = static_cast<unsigned char>(value2);
+  if (factor == 0x00) {
+    return;
+  } else if (factor == 0x01) {
+    emitByte(0x00); genCellOperand(0, value1);  // add byte ptr [rbx + value1], al
+  } else if (factor == 0xff) {
+    emitByte(0x28); genCellOperand(0, value1);  // sub byte ptr [rbx + value1], al
+  } else {
+    emitByte(0x6b); emitByte(0xc8); emitByte(factor);  // imul ecx, eax, imm8
+    emitByte(0x00); genCellOperand(1, value1);  // add byte ptr [rbx + value1], cl
+  }
+}
+
+
+inline void
+GeneratorElfX64::genMultiCmulEnd(void)
+{
+  genAssign(0);
+}
+
+
+inline void
+GeneratorElfX64::genInfLoop(void)
+{
+  emitByte(0x80); emitByte(0x3b); emitByte(0x00);  // cmp byte ptr [rbx], 0
+  emitByte(0x75); emitByte(0xfe);  // jne $
+}
+
+
+/*!
+ * @brief Store the string into the output buffer chunk by chunk
+ *
+ * The buffer is flushed in advance if the chunk doesn't fit in it.
+ * @param [in] str  String to print
+ */
+inline void
+GeneratorElfX64::genPuts(const std::string &str, int)
+{
+  for (std::string::size_type pos = 0; pos < str.size(); pos += PUTS_CHUNK_SIZE) {
+    int n = static_cast<int>(std::min(str.size() - pos, static_cast<std::string::size_type>(PUTS_CHUNK_SIZE)));
+    emitByte(0x49); emitByte(0x81); emitByte(0xfc); emitDword(static_cast<int>(ADDR_OUTPUT_BUFFER + OUTPUT_BUFFER_SIZE) - n);  // cmp r12, ADDR_OUTPUT_BUFFER + OUTPUT_BUFFER_SIZE - n
+    emitByte(0x72); emitByte(0x05);  // jb +5
+    genCall(flushRoutine);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+      int imm = 0;
+      for (int j = 3; j >= 0; j--) {
+        imm = static_cast<int>((static_cast<unsigned int>(imm) << 8) | static_cast<unsigned char>(str[pos + static_cast<std::string::size_type>(i + j)]));
+      }
+      emitByte(0x41); emitByte(0xc7); emitByte(0x84); emitByte(0x24); emitDword(i); emitDword(imm);  // mov dword ptr [r12 + i], imm
+    }
+    for (; i < n; i++) {
+      emitByte(0x41); emitByte(0xc6); emitByte(0x84); emitByte(0x24); emitDword(i); emitByte(static_cast<unsigned char>(str[pos + static_cast<std::string::size_type>(i)]));  // mov byte ptr [r12 + i], imm
+    }
+    emitByte(0x49); emitByte(0x81); emitByte(0xc4); emitDword(n);  // add r12, n
+  }
+}
+
+
+inline void
+GeneratorElfX64::genIf(void)
+{
+  genLoopStart();
+}
+
+
+inline void
+GeneratorElfX64::genEndIf(void)
+{
+  std::size_t start = loopStack.top();
+  loopStack.pop();
+  patchDword(start + 5, getRelative(getOffset(), start + 9));
+}
+
+
+/*!
+ * @brief Generate ModR/M byte and displacement which point to [rbx + offset]
+ * @param [in] reg     Value of reg field of ModR/M byte
+ * @param [in] offset  Offset from the current cell
+ */
+inline void
+GeneratorElfX64::genCellOperand(int reg, int offset)
+{
+  if (offset == 0) {
+    emitByte(static_cast<unsigned char>(0x03 | (reg << 3)));
+  } else if (offset >= -128 && offset <= 127) {
+    emitByte(static_cast<unsigned char>(0x43 | (reg << 3)));
+    emitByte(static_cast<unsigned char>(offset));
+  } else {
+    emitByte(static_cast<unsigned char>(0x83 | (reg << 3)));
+    emitDword(offset);
+  }
+}
+
+
+/*!
+ * @brief Generate the shortest instruction which adds value to rbx
+ * @param [in] value  Value to add to rbx
+ */
+inline void
+GeneratorElfX64::genAddImm(int value)
+{
+  if (value == 1) {
+    emitByte(0x48); emitByte(0xff); emitByte(0xc3);  // inc rbx
+  } else if (value == -1) {
+    emitByte(0x48); emitByte(0xff); emitByte(0xcb);  // dec rbx
+  } else if (value >= -128 && value <= 127) {
+    emitByte(0x48); emitByte(0x83); emitByte(0xc3); emitByte(static_cast<unsigned char>(value));  // add rbx, imm8
+  } else if (value != 0) {
+    emitByte(0x48); emitByte(0x81); emitByte(0xc3); emitDword(value);  // add rbx, imm32
+  }
+}
+
+
+/*!
+ * @brief Generate the routine which writes out the output buffer
+ *
+ * The routine clobbers rax, rcx, rdx, rsi, rdi and r11.
+ */
+inline void
+GeneratorElfX64::genFlushRoutine(void)
+{
+  flushRoutine = getOffset();
+  emitByte(0xbe); emitDword(ADDR_OUTPUT_BUFFER);  // mov esi, ADDR_OUTPUT_BUFFER
+  std::size_t loop = getOffset();
+  emitByte(0x4c); emitByte(0x89); emitByte(0xe2);  // mov rdx, r12
+  emitByte(0x48); emitByte(0x29); emitByte(0xf2);  // sub rdx, rsi
+  emitByte(0x7e);  // jle rel8 (patched below)
+  std::size_t doneRel1 = getOffset();
+  emitByte(0x00);
+  emitByte(0xb8); emitDword(0x01);  // mov eax, 1 (write)
+  emitByte(0xbf); emitDword(0x01);  // mov edi, 1 (stdout)
+  emitByte(0x0f); emitByte(0x05);  // syscall
+  emitByte(0x48); emitByte(0x85); emitByte(0xc0);  // test rax, rax
+  emitByte(0x7e);  // jle rel8 (patched below)
+  std::size_t doneRel2 = getOffset();
+  emitByte(0x00);
+  // Continue until all bytes are written
+  emitByte(0x48); emitByte(0x01); emitByte(0xc6);  // add rsi, rax
+  emitByte(0xeb); emitByte(getRelative(loop, getOffset() + 1));  // jmp loop
+  patchByte(doneRel1, getRelative(getOffset(), doneRel1 + 1));
+  patchByte(doneRel2, getRelative(getOffset(), doneRel2 + 1));
+  emitByte(0x41); emitByte(0xbc); emitDword(ADDR_OUTPUT_BUFFER);  // mov r12d, ADDR_OUTPUT_BUFFER
+  emitByte(0xc3);  // ret
+}
+
+
+/*!
+ * @brief Generate the routine which reads one byte into [rsi]
+ *
+ * The input buffer is refilled with one read system call when it is empty,
+ * after the output buffer is flushed.
+ * On EOF, [rsi] is left unchanged.
+ */
+inline void
+GeneratorElfX64::genGetcharRoutine(void)
+{
+  getcharRoutine = getOffset();
+  emitByte(0x4d); emitByte(0x39); emitByte(0xf5);  // cmp r13, r14
+  emitByte(0x75);  // jne rel8 (patched below)
+  std::size_t haveRel = getOffset();
+  emitByte(0x00);
+  emitByte(0x56);  // push rsi
+  genCall(flushRoutine);
+  emitByte(0x31); emitByte(0xc0);  // xor eax, eax (read)
+  emitByte(0x31); emitByte(0xff);  // xor edi, edi (stdin)
+  emitByte(0xbe); emitDword(ADDR_INPUT_BUFFER);  // mov esi, ADDR_INPUT_BUFFER
+  emitByte(0xba); emitDword(INPUT_BUFFER_SIZE);  // mov edx, INPUT_BUFFER_SIZE
+  emitByte(0x0f); emitByte(0x05);  // syscall
+  emitByte(0x5e);  // pop rsi
+  emitByte(0x48); emitByte(0x85); emitByte(0xc0);  // test rax, rax
+  emitByte(0x7e);  // jle rel8 (patched below)
+  std::size_t retRel = getOffset();
+  emitByte(0x00);
+  emitByte(0x41); emitByte(0xbd); emitDword(ADDR_INPUT_BUFFER);  // mov r13d, ADDR_INPUT_BUFFER
+  emitByte(0x4d); emitByte(0x8d); emitByte(0x74); emitByte(0x05); emitByte(0x00);  // lea r14, [r13 + rax]
+  patchByte(haveRel, getRelative(getOffset(), haveRel + 1));
+  emitByte(0x41); emitByte(0x8a); emitByte(0x45); emitByte(0x00);  // mov al, byte ptr [r13]
+  emitByte(0x49); emitByte(0xff); emitByte(0xc5);  // inc r13
+  emitByte(0x88); emitByte(0x06);  // mov byte ptr [rsi], al
+  patchByte(retRel, getRelative(getOffset(), retRel + 1));
+  emitByte(0xc3);  // ret
+}
+
+
+/*!
+ * @brief Generate the call to the runtime routine
+ * @param [in] target  Offset of the routine from the top of the code
+ */
+inline void
+GeneratorElfX64::genCall(std::size_t target)
+{
+  emitByte(0xe8); emitDword(getRelative(target, getOffset() + sizeof(int32_t)));  // call rel32
+}
+
+
+/*!
+ * @brief Get the size of .bss, which holds the I/O buffers and the tape
+ * @return Size of .bss
+ */
+inline std::size_t
+GeneratorElfX64::getBssSize(void) const
+{
+  return OUTPUT_BUFFER_SIZE + INPUT_BUFFER_SIZE + memorySize;
 }
 
 
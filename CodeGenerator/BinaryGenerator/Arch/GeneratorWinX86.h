@@ -31,8 +31,8 @@ private:
   inline void genLoopStart(void);
   inline void genLoopEnd(void);
 public:
-  GeneratorWinX86(BfIR irCode, std::size_t codeSize=DEFAULT_MAX_CODE_SIZE) :
-    BinaryGenerator(irCode) {}
+  GeneratorWinX86(const BfIRModule &irModule) :
+    BinaryGenerator(irModule, EXE_SIZE) {}
 };
 
 
@@ -41,20 +41,23 @@ public:
 inline void
 GeneratorWinX86::genPlorogue(void)
 {
-  codePtr = code + PE_HEADER_SIZE + IDATA_SIZE;
-  *codePtr++ = 0x31; *codePtr++ = 0xc9;  // xor ecx, ecx
-  *codePtr++ = 0x57;  // push edi
-  *codePtr++ = 0xbf; *reinterpret_cast<int *>(codePtr) = ADDR_BUF;  // mov edi, addr_buf
-  codePtr += sizeof(int);
+  emitZeros(PE_HEADER_SIZE + IDATA_SIZE);
+  emitByte(0x31); emitByte(0xc9);  // xor ecx, ecx
+  emitByte(0x57);  // push edi
+  emitByte(0xbf); emitDword(ADDR_BUF);  // mov edi, addr_buf
 }
 
 
 inline void
 GeneratorWinX86::genEpirogue(void)
 {
-  *codePtr++ = 0x5f;  // pop edi
-  *codePtr++ = 0x31; *codePtr++ = 0xc0;  // xor eax, eax
-  *codePtr++ = 0xc3;  // ret
+  emitByte(0x5f);  // pop edi
+  emitByte(0x31); emitByte(0xc0);  // xor eax, eax
+  emitByte(0xc3);  // ret
+  if (getOffset() > EXE_SIZE) {
+    throw std::length_error("GeneratorWinX86: code exceeds .text section");
+  }
+  emitZeros(EXE_SIZE - getOffset());
   codeSize = CODE_SIZE;
 }
 
@@ -82,7 +85,8 @@ GeneratorWinX86::genHeader(void)
   static const char STR_PUTCHAR[] = "putchar";
   static const char STR_GETCHAR[] = "getchar";
 
-  unsigned char *ptr = code;
+  unsigned char *base = getPointer(0, PE_HEADER_SIZE + IDATA_SIZE);
+  unsigned char *ptr = base;
   std::memcpy(ptr, STUB, sizeof(STUB));
   ptr += sizeof(STUB);
 
@@ -157,7 +161,7 @@ GeneratorWinX86::genHeader(void)
   ish->Misc.VirtualSize = 65536;
   ish->VirtualAddress = 0x6000;
   ish->Characteristics = 0xc0400080;
-  ptr = code + PE_HEADER_SIZE;
+  ptr = base + PE_HEADER_SIZE;
 
   int *idt = reinterpret_cast<int *>(ptr);
   // IDT 1
@@ -212,7 +216,7 @@ inline void
 GeneratorWinX86::genNextN(int value)
 {
   for (int i = 0; i < value; i++) {
-    *codePtr++ = 0x66; *codePtr++ = 0x41;  // inc cx
+    emitByte(0x66); emitByte(0x41);  // inc cx
   }
 }
 
@@ -221,7 +225,7 @@ inline void
 GeneratorWinX86::genPrevN(int value)
 {
   for (int i = 0; i < value; i++) {
-    *codePtr++ = 0x66; *codePtr++ = 0x49;  // dec cx
+    emitByte(0x66); emitByte(0x49);  // dec cx
   }
 }
 
@@ -230,7 +234,7 @@ inline void
 GeneratorWinX86::genAdd(int value)
 {
   for (int i = 0; i < value; i++) {
-    *codePtr++ = 0xfe; *codePtr++ = 0x04; *codePtr++ = 0x0f;  // inc byte [edi+ecx]
+    emitByte(0xfe); emitByte(0x04); emitByte(0x0f);  // inc byte [edi+ecx]
   }
 }
 
@@ -239,7 +243,7 @@ inline void
 GeneratorWinX86::genSub(int value)
 {
   for (int i = 0; i < value; i++) {
-    *codePtr++ = 0xfe; *codePtr++ = 0x0c; *codePtr++ = 0x0f;  // dec byte [edi+ecx]
+    emitByte(0xfe); emitByte(0x0c); emitByte(0x0f);  // dec byte [edi+ecx]
   }
 }
 
@@ -247,54 +251,48 @@ GeneratorWinX86::genSub(int value)
 inline void
 GeneratorWinX86::genPutchar(void)
 {
-  *codePtr++ = 0x51;  // push ecx
-  *reinterpret_cast<int *>(codePtr) = 0x0f04b60f;  // movzx eax,byte [edi+ecx]
-  codePtr += sizeof(int);
+  emitByte(0x51);  // push ecx
+  emitDword(0x0f04b60f);  // movzx eax,byte [edi+ecx]
 
-  *codePtr++ = 0x50;  // push eax
-  *codePtr++ = 0xa1; *reinterpret_cast<int *>(codePtr) = ADDR_PUTCHAR;  // mov eax, [addr_putchar]
-  codePtr += sizeof(int);
+  emitByte(0x50);  // push eax
+  emitByte(0xa1); emitDword(ADDR_PUTCHAR);  // mov eax, [addr_putchar]
 
-  *codePtr++ = 0xff; *codePtr++ = 0xd0;  // call eax
-  *codePtr++ = 0x58;  // pop eax
-  *codePtr++ = 0x59;  // pop ecx
+  emitByte(0xff); emitByte(0xd0);  // call eax
+  emitByte(0x58);  // pop eax
+  emitByte(0x59);  // pop ecx
 }
 
 
 inline void
 GeneratorWinX86::genGetchar(void)
 {
-  *codePtr++ = 0x51;  // push ecx
-  *codePtr++ = 0xa1; *reinterpret_cast<int *>(codePtr) = ADDR_GETCHAR;  // mov eax, [addr_getchar]
-  codePtr += sizeof(int);
+  emitByte(0x51);  // push ecx
+  emitByte(0xa1); emitDword(ADDR_GETCHAR);  // mov eax, [addr_getchar]
 
-  *codePtr++ = 0xff; *codePtr++ = 0xd0;  // call eax
-  *codePtr++ = 0x59;  // pop ecx
-  *codePtr++ = 0x88; *codePtr++ = 0x04; *codePtr++ = 0x0f;  // mov [edi+ecx],al
+  emitByte(0xff); emitByte(0xd0);  // call eax
+  emitByte(0x59);  // pop ecx
+  emitByte(0x88); emitByte(0x04); emitByte(0x0f);  // mov [edi+ecx],al
 }
 
 
 inline void
 GeneratorWinX86::genLoopStart(void)
 {
-  loopStack.push(codePtr);
-  *reinterpret_cast<int *>(codePtr) = 0x000f3c80;  // cmp byte [edi+ecx], 0
-  codePtr += sizeof(int);
+  loopStack.push(getOffset());
+  emitDword(0x000f3c80);  // cmp byte [edi+ecx], 0
   // jz Jump to just behind the corresponding ] (define address later)
-  *codePtr++ = 0x0f; *codePtr++ = 0x84;
-  *reinterpret_cast<int *>(codePtr) = 0x00000000;  // cmp byte [edi+ecx], 0
-  codePtr += sizeof(int);
+  emitByte(0x0f); emitByte(0x84);
+  emitDword(0x00000000);
 }
 
 
 inline void
 GeneratorWinX86::genLoopEnd(void)
 {
-  unsigned char *_codePtr = loopStack.top();
+  std::size_t start = loopStack.top();
   loopStack.pop();
-  *codePtr++ = 0xe9; *reinterpret_cast<int *>(codePtr) = _codePtr - (codePtr + sizeof(int));  // jmp idxLoop
-  codePtr += sizeof(int);
-  *reinterpret_cast<int *>(_codePtr + 6) = codePtr - (_codePtr + 10);  // Rewrites the top of the loop
+  emitByte(0xe9); emitDword(getRelative(start, getOffset() + sizeof(int)));  // jmp idxLoop
+  patchDword(start + 6, getRelative(getOffset(), start + 10));  // Rewrites the top of the loop
 }
 
 
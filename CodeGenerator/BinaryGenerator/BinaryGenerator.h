@@ -6,7 +6,15 @@
 #ifndef BINARY_GENERATOR_H
 #define BINARY_GENERATOR_H
 
+#include <cstring>
 #include <stack>
+#include <stdexcept>
+#include <vector>
+#if __cplusplus >= 201103L
+#  include <cstdint>
+#else
+#  include <stdint.h>
+#endif  // __cplusplus >= 201103L
 #include "../CodeGenerator.h"
 
 
@@ -15,20 +23,43 @@ namespace bf {
 
 /*!
  * @brief Super class for executable binary generator
+ *
+ * Binary is emitted into a buffer which grows on demand.
+ * Positions in the buffer are held as offsets, so that they remain valid
+ * after the buffer is reallocated.
  */
 class BinaryGenerator : public CodeGenerator {
+private:
+  std::vector<unsigned char> code;
 protected:
   virtual void genPlorogue(void) = 0;
   virtual void genEpirogue(void) = 0;
-  static const std::size_t DEFAULT_MAX_CODE_SIZE = 1048576;
+  static const std::size_t DEFAULT_CODE_SIZE = 65536;
   std::size_t codeSize;
   std::size_t binSize;
-  std::stack<unsigned char *> loopStack;
+  std::stack<std::size_t> loopStack;
+
+  inline std::size_t getOffset(void) const { return code.size(); }
+  inline void emitByte(int value);
+  inline void emitDword(int value);
+  inline void emitBytes(const void *data, std::size_t size);
+  inline void emitZeros(std::size_t size);
+  inline void patchByte(std::size_t offset, int value);
+  inline void patchDword(std::size_t offset, int value);
+  inline unsigned char *getPointer(std::size_t offset, std::size_t size);
+  static inline int getRelative(std::size_t target, std::size_t origin);
 public:
-  BinaryGenerator(BfIR irCode) :
-    CodeGenerator(irCode) {}
+  BinaryGenerator(const BfIRModule &irModule, std::size_t codeSize=DEFAULT_CODE_SIZE) :
+    CodeGenerator(irModule),
+    code(),
+    codeSize(0),
+    binSize(0),
+    loopStack()
+  {
+    code.reserve(codeSize);
+  }
   inline void genCode(void);
-  inline unsigned char *getCode(void) const { return code; }
+  inline const unsigned char *getCode(void) const { return code.empty() ? nullptr : &code[0]; }
   inline std::size_t getSize(void) const { return binSize; }
 };
 
@@ -47,5 +78,108 @@ BinaryGenerator::genCode(void)
 }
 
 
+/*!
+ * @brief Append one byte
+ * @param [in] value  Byte to append; only the lower 8 bits are used
+ */
+inline void
+BinaryGenerator::emitByte(int value)
+{
+  code.push_back(static_cast<unsigned char>(value));
+}
+
+
+/*!
+ * @brief Append 32-bit little-endian value
+ * @param [in] value  Value to append
+ */
+inline void
+BinaryGenerator::emitDword(int value)
+{
+  int32_t dword = static_cast<int32_t>(value);
+  emitBytes(&dword, sizeof(dword));
+}
+
+
+/*!
+ * @brief Append the byte sequence
+ * @param [in] data  Pointer to the byte sequence
+ * @param [in] size  Size of the byte sequence
+ */
+inline void
+BinaryGenerator::emitBytes(const void *data, std::size_t size)
+{
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+  code.insert(code.end(), bytes, bytes + size);
+}
+
+
+/*!
+ * @brief Append zero-filled bytes, which are filled in later
+ * @param [in] size  The number of bytes
+ */
+inline void
+BinaryGenerator::emitZeros(std::size_t size)
+{
+  code.resize(code.size() + size, 0x00);
+}
+
+
+/*!
+ * @brief Overwrite one byte which is already emitted
+ * @param [in] offset  Offset of the byte
+ * @param [in] value   New value
+ */
+inline void
+BinaryGenerator::patchByte(std::size_t offset, int value)
+{
+  *getPointer(offset, 1) = static_cast<unsigned char>(value);
+}
+
+
+/*!
+ * @brief Overwrite 32-bit value which is already emitted
+ * @param [in] offset  Offset of the value
+ * @param [in] value   New value
+ */
+inline void
+BinaryGenerator::patchDword(std::size_t offset, int value)
+{
+  int32_t dword = static_cast<int32_t>(value);
+  std::memcpy(getPointer(offset, sizeof(dword)), &dword, sizeof(dword));
+}
+
+
+/*!
+ * @brief Get the pointer to the emitted bytes
+ *
+ * The pointer is invalidated by the next emission.
+ * @param [in] offset  Offset of the bytes
+ * @param [in] size    The number of bytes which will be accessed
+ * @return Pointer to the bytes
+ */
+inline unsigned char *
+BinaryGenerator::getPointer(std::size_t offset, std::size_t size)
+{
+  if (offset > code.size() || size > code.size() - offset) {
+    throw std::out_of_range("BinaryGenerator: access out of the emitted code");
+  }
+  return &code[offset];
+}
+
+
+/*!
+ * @brief Get the relative displacement between two offsets
+ * @param [in] target  Offset of the destination
+ * @param [in] origin  Offset which the displacement is relative to
+ * @return target - origin
+ */
+inline int
+BinaryGenerator::getRelative(std::size_t target, std::size_t origin)
+{
+  return static_cast<int>(static_cast<std::ptrdiff_t>(target) - static_cast<std::ptrdiff_t>(origin));
+}
+
+
 }  // namespace bf
 #endif  // BINARY_GENERATOR_H
@@ -6,7 +6,7 @@
 #ifndef CODE_GENERATOR_H
 #define CODE_GENERATOR_H
 
-#include <algorithm>
+#include <string>
 #include "../BfIRCompiler.h"
 
 
@@ -17,12 +17,8 @@ namespace bf {
  * @brief Super class for source code generator and binary generator
  */
 class CodeGenerator {
-private:
-  static const std::size_t DEFAULT_MAX_CODE_SIZE = 1048576;
 protected:
-  BfIR irCode;
-  unsigned char *code;
-  unsigned char *codePtr;
+  BfIRModule irModule;
   void genMainCode(void);
   inline virtual void genHeader(void) = 0;
   inline virtual void genFooter(void) = 0;
@@ -40,6 +36,8 @@ protected:
   inline virtual void genSubAt(int value1, int value2);
   inline virtual void genPutchar(void) = 0;
   inline virtual void genGetchar(void) = 0;
+  inline virtual void genPutcharAt(int value);
+  inline virtual void genGetcharAt(int value);
   inline virtual void genLoopStart(void) = 0;
   inline virtual void genLoopEnd(void) = 0;
   inline virtual void genAssign(int value);
@@ -48,31 +46,24 @@ protected:
   inline virtual void genAddVar(int value);
   inline virtual void genSubVar(int value);
   inline virtual void genCmulVar(int value1, int value2);
+  inline virtual void genMultiCmulStart(int value);
+  inline virtual void genMultiCmulTarget(int value1, int value2);
+  inline virtual void genMultiCmulEnd(void);
   inline virtual void genInfLoop(void);
+  inline virtual void genPuts(const std::string &str, int value);
+  inline virtual void genIf(void);
+  inline virtual void genEndIf(void);
 public:
-  CodeGenerator(BfIR &irCode, std::size_t codeSize=DEFAULT_MAX_CODE_SIZE) :
-    irCode(irCode), code(NULL), codePtr(NULL)
+  CodeGenerator(const BfIRModule &irModule) :
+    irModule(irModule)
+  {}
+  CodeGenerator(void) :
+    irModule()
+  {}
+
+  void setIRModule(const BfIRModule &irModule)
   {
-    code = new unsigned char[codeSize];
-    std::fill_n(code, codeSize, 0);
-    codePtr = code;
-  }
-  CodeGenerator(std::size_t codeSize=DEFAULT_MAX_CODE_SIZE) :
-    code(NULL),
-    codePtr(NULL)
-  {
-    code = new unsigned char[codeSize];
-    std::fill_n(code, codeSize, 0);
-    codePtr = code;
-  }
-  ~CodeGenerator(void)
-  {
-    delete[] code;
-  }
-
-  void setIRCode(BfIR &irCode)
-  {
-    this->irCode = irCode;
+    this->irModule = irModule;
   }
   virtual void genCode(void) = 0;
 };
@@ -81,6 +72,7 @@ public:
 inline void
 CodeGenerator::genMainCode(void)
 {
+  const BfIR &irCode = irModule.getCode();
   for (BfIR::const_iterator cmd = irCode.begin(), end = irCode.end(); cmd != end; cmd++) {
     switch (cmd->type) {
       case BfInstruction::NEXT:
@@ -120,10 +112,10 @@ CodeGenerator::genMainCode(void)
         genSubAt(cmd->value1, cmd->value2);
         break;
       case BfInstruction::PUTCHAR:
-        genPutchar();
+        cmd->value1 == 0 ? genPutchar() : genPutcharAt(cmd->value1);
         break;
       case BfInstruction::GETCHAR:
-        genGetchar();
+        cmd->value1 == 0 ? genGetchar() : genGetcharAt(cmd->value1);
         break;
       case BfInstruction::LOOP_START:
         genLoopStart();
@@ -152,9 +144,32 @@ CodeGenerator::genMainCode(void)
       case BfInstruction::CMUL_VAR:
         genCmulVar(cmd->value1, cmd->value2);
         break;
+      case BfInstruction::MULTI_CMUL_VAR:
+        genMultiCmulStart(cmd->value1);
+        for (BfIR::const_iterator last = cmd + cmd->value1; cmd != last;) {
+          cmd++;
+          genMultiCmulTarget(cmd->value1, cmd->value2);
+        }
+        genMultiCmulEnd();
+        break;
+      case BfInstruction::CMUL_TARGET:
+        // Always consumed by MULTI_CMUL_VAR
+        break;
       case BfInstruction::INF_LOOP:
         genInfLoop();
         break;
+      case BfInstruction::CHECK:
+        // Generated code doesn't check the bounds of the tape
+        break;
+      case BfInstruction::PUTS:
+        genPuts(irModule.getStrings()[static_cast<BfStringPool::size_type>(cmd->value1)], cmd->value2);
+        break;
+      case BfInstruction::IF:
+        genIf();
+        break;
+      case BfInstruction::END_IF:
+        genEndIf();
+        break;
     }
   }
 }
@@ -232,6 +247,36 @@ CodeGenerator::genSubAt(int value1, int value2)
 }
 
 
+inline void
+CodeGenerator::genPutcharAt(int value)
+{
+  if (value > 0) {
+    genNextN(value);
+    genPutchar();
+    genPrevN(value);
+  } else {
+    genPrevN(-value);
+    genPutchar();
+    genNextN(-value);
+  }
+}
+
+
+inline void
+CodeGenerator::genGetcharAt(int value)
+{
+  if (value > 0) {
+    genNextN(value);
+    genGetchar();
+    genPrevN(value);
+  } else {
+    genPrevN(-value);
+    genGetchar();
+    genNextN(-value);
+  }
+}
+
+
 inline void
 CodeGenerator::genAssign(int value)
 {
@@ -378,6 +423,36 @@ CodeGenerator::genCmulVar(int value1, int value2)
 }
 
 
+inline void
+CodeGenerator::genMultiCmulStart(int)
+{
+  genLoopStart();
+  genDec();
+}
+
+
+inline void
+CodeGenerator::genMultiCmulTarget(int value1, int value2)
+{
+  if (value2 == 1) {
+    genIncAt(value1);
+  } else if (value2 == -1) {
+    genDecAt(value1);
+  } else if (value2 > 0) {
+    genAddAt(value1, value2);
+  } else {
+    genSubAt(value1, -value2);
+  }
+}
+
+
+inline void
+CodeGenerator::genMultiCmulEnd(void)
+{
+  genLoopEnd();
+}
+
+
 inline void
 CodeGenerator::genInfLoop(void)
 {
@@ -386,5 +461,53 @@ CodeGenerator::genInfLoop(void)
 }
 
 
+/*!
+ * @brief Print the string byte by byte through the scratch cell
+ *
+ * The scratch cell is assigned by the following instructions, so its value
+ * needn't be restored.
+ * @param [in] str    String to print
+ * @param [in] value  Offset of the scratch cell
+ */
+inline void
+CodeGenerator::genPuts(const std::string &str, int value)
+{
+  for (std::string::const_iterator itr = str.begin(), end = str.end(); itr != end; itr++) {
+    int ch = static_cast<unsigned char>(*itr);
+    if (value == 0) {
+      genAssign(ch);
+      genPutchar();
+    } else {
+      genAssignAt(value, ch);
+      genPutcharAt(value);
+    }
+  }
+}
+
+
+
+/*!
+ * @brief Generate the start of the loop which runs at most once
+ *
+ * The loop is valid as it is, so it is generated as an ordinary loop by
+ * default.
+ */
+inline void
+CodeGenerator::genIf(void)
+{
+  genLoopStart();
+}
+
+
+/*!
+ * @brief Generate the end of the loop which runs at most once
+ */
+inline void
+CodeGenerator::genEndIf(void)
+{
+  genLoopEnd();
+}
+
+
 }  // namespace bf
 #endif  // CODE_GENERATOR_H
@@ -26,6 +26,8 @@ private:
   inline void genSubAt(int value1, int value2);
   inline void genPutchar(void);
   inline void genGetchar(void);
+  inline void genPutcharAt(int value);
+  inline void genGetcharAt(int value);
   inline void genLoopStart(void);
   inline void genLoopEnd(void);
   inline void genAssign(int value);
@@ -34,11 +36,16 @@ private:
   inline void genAddVar(int value);
   inline void genSubVar(int value);
   inline void genCmulVar(int value1, int value2);
+  inline void genMultiCmulStart(int value);
+  inline void genMultiCmulTarget(int value1, int value2);
+  inline void genMultiCmulEnd(void);
   inline void genInfLoop(void);
+  inline void genPuts(const std::string &str, int value);
+  inline void genIf(void);
 public:
-  GeneratorC(BfIR irCode, std::size_t codeSize=DEFAULT_MAX_CODE_SIZE,
+  GeneratorC(const BfIRModule &irModule, std::size_t /* codeSize */=DEFAULT_MAX_CODE_SIZE,
       const char *indent="  ") :
-    SourceGenerator(irCode, indent, 1) {}
+    SourceGenerator(irModule, indent, 1) {}
 };
 
 
@@ -80,9 +87,13 @@ GeneratorC::genFooter(void)
                "INLINE static void *\n"
                "memrchr(const void *s, int c, size_t n)\n"
                "{\n"
-            << indent << "const char *_s = (const char *) s;\n"
-            << indent << "for (; *((int *) _s) != c; _s--);\n"
-            << indent << "return (void *) _s;\n"
+            << indent << "const unsigned char *_s = (const unsigned char *) s + n;\n"
+            << indent << "while (_s != s) {\n"
+            << indent << indent << "if (*--_s == (unsigned char) c) {\n"
+            << indent << indent << indent << "return (void *) _s;\n"
+            << indent << indent << "}\n"
+            << indent << "}\n"
+            << indent << "return NULL;\n"
                "}\n"
                "#endif"
             << std::endl;
@@ -221,6 +232,32 @@ GeneratorC::genGetchar(void)
 }
 
 
+inline void
+GeneratorC::genPutcharAt(int value)
+{
+  genIndent();
+  if (value > 0) {
+    std::cout << "putchar(*(ptr + " << value;
+  } else {
+    std::cout << "putchar(*(ptr - " << -value;
+  }
+  std::cout << "));\n";
+}
+
+
+inline void
+GeneratorC::genGetcharAt(int value)
+{
+  genIndent();
+  if (value > 0) {
+    std::cout << "*(ptr + " << value;
+  } else {
+    std::cout << "*(ptr - " << -value;
+  }
+  std::cout << ") = (unsigned char) getchar();\n";
+}
+
+
 inline void
 GeneratorC::genLoopStart(void)
 {
@@ -267,7 +304,7 @@ GeneratorC::genSearchZero(int value)
   if (value == 1) {
     std::cout << "ptr = memchr(ptr, 0, sizeof(memory));\n";
   } else if (value == -1) {
-    std::cout << "ptr = memrchr(ptr, 0, sizeof(memory));\n";
+    std::cout << "ptr = memrchr(memory, 0, ptr - memory + 1);\n";
   } else if (value > 0) {
     std::cout << "for (; *ptr; ptr += " << value << ");\n";
   } else if (value < 0) {
@@ -333,6 +370,39 @@ GeneratorC::genCmulVar(int value1, int value2)
 }
 
 
+inline void
+GeneratorC::genMultiCmulStart(int)
+{
+  genIndent();
+  std::cout << "if (*ptr) {\n";
+  indentLevel++;
+}
+
+
+inline void
+GeneratorC::genMultiCmulTarget(int value1, int value2)
+{
+  genIndent();
+  if (value1 >= 0) {
+    std::cout << "*(ptr + " <<  value1;
+  } else {
+    std::cout << "*(ptr - " << -value1;
+  }
+  std::cout << ") += *ptr * " << value2 << ";\n";
+}
+
+
+inline void
+GeneratorC::genMultiCmulEnd(void)
+{
+  genIndent();
+  std::cout << "*ptr = 0;\n";
+  indentLevel--;
+  genIndent();
+  std::cout << "}\n";
+}
+
+
 inline void
 GeneratorC::genInfLoop(void)
 {
@@ -345,5 +415,24 @@ GeneratorC::genInfLoop(void)
 }
 
 
+inline void
+GeneratorC::genPuts(const std::string &str, int)
+{
+  genIndent();
+  std::cout << "fwrite(";
+  genStringLiteral(str, OCTAL_ESCAPE);
+  std::cout << ", 1, " << str.size() << ", stdout);\n";
+}
+
+
+inline void
+GeneratorC::genIf(void)
+{
+  genIndent();
+  std::cout << "if (*ptr) {\n";
+  indentLevel++;
+}
+
+
 }  // namespace bf
 #endif  // GENERATOR_C_H
@@ -26,6 +26,8 @@ protected:
   inline void genSubAt(int value1, int value2);
   inline void genPutchar(void);
   inline void genGetchar(void);
+  inline void genPutcharAt(int value);
+  inline void genGetcharAt(int value);
   inline void genLoopStart(void);
   inline void genLoopEnd(void);
   inline void genAssign(int value);
@@ -34,11 +36,16 @@ protected:
   inline void genAddVar(int value);
   inline void genSubVar(int value);
   inline void genCmulVar(int value1, int value2);
+  inline void genMultiCmulStart(int value);
+  inline void genMultiCmulTarget(int value1, int value2);
+  inline void genMultiCmulEnd(void);
   inline void genInfLoop(void);
+  inline void genPuts(const std::string &str, int value);
+  inline void genIf(void);
 public:
-  GeneratorCSharp(BfIR irCode, std::size_t codeSize=DEFAULT_MAX_CODE_SIZE,
+  GeneratorCSharp(const BfIRModule &irModule, std::size_t /* codeSize */=DEFAULT_MAX_CODE_SIZE,
       const char *indent="    ") :
-    SourceGenerator(irCode, indent, 2) {}
+    SourceGenerator(irModule, indent, 2) {}
 };
 
 
@@ -199,6 +206,32 @@ GeneratorCSharp::genGetchar(void)
 }
 
 
+inline void
+GeneratorCSharp::genPutcharAt(int value)
+{
+  genIndent();
+  if (value > 0) {
+    std::cout << "Console.Write((char) memory[idx + " << value;
+  } else {
+    std::cout << "Console.Write((char) memory[idx - " << -value;
+  }
+  std::cout << "]);\n";
+}
+
+
+inline void
+GeneratorCSharp::genGetcharAt(int value)
+{
+  genIndent();
+  if (value > 0) {
+    std::cout << "memory[idx + " << value;
+  } else {
+    std::cout << "memory[idx - " << -value;
+  }
+  std::cout << "] = Console.Read();\n";
+}
+
+
 inline void
 GeneratorCSharp::genLoopStart(void)
 {
@@ -312,6 +345,39 @@ GeneratorCSharp::genCmulVar(int value1, int value2)
 }
 
 
+inline void
+GeneratorCSharp::genMultiCmulStart(int)
+{
+  genIndent();
+  std::cout << "if (memory[idx] != 0) {\n";
+  indentLevel++;
+}
+
+
+inline void
+GeneratorCSharp::genMultiCmulTarget(int value1, int value2)
+{
+  genIndent();
+  if (value1 >= 0) {
+    std::cout << "memory[idx + " <<  value1;
+  } else {
+    std::cout << "memory[idx - " << -value1;
+  }
+  std::cout << "] += (byte) (memory[idx] * " << value2 << ");\n";
+}
+
+
+inline void
+GeneratorCSharp::genMultiCmulEnd(void)
+{
+  genIndent();
+  std::cout << "memory[idx] = 0;\n";
+  indentLevel--;
+  genIndent();
+  std::cout << "}\n";
+}
+
+
 inline void
 GeneratorCSharp::genInfLoop(void)
 {
@@ -324,5 +390,26 @@ GeneratorCSharp::genInfLoop(void)
 }
 
 
+inline void
+GeneratorCSharp::genPuts(const std::string &str, int)
+{
+  genIndent();
+  std::cout << "Console.Write(";
+  genStringLiteral(str, UNICODE_ESCAPE);
+  std::cout << ");\n";
+}
+
+
+inline void
+GeneratorCSharp::genIf(void)
+{
+  genIndent();
+  std::cout << "if (memory[idx] != 0)\n";
+  genIndent();
+  std::cout << "{\n";
+  indentLevel++;
+}
+
+
 }  // namespace bf
 #endif  // GENERATOR_CSHARP_H
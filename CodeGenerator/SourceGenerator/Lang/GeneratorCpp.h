@@ -28,6 +28,8 @@ private:
   inline void genSubAt(int value1, int value2);
   inline void genPutchar(void);
   inline void genGetchar(void);
+  inline void genPutcharAt(int value);
+  inline void genGetcharAt(int value);
   inline void genLoopStart(void);
   inline void genLoopEnd(void);
   inline void genAssign(int value);
@@ -36,11 +38,16 @@ private:
   inline void genAddVar(int value);
   inline void genSubVar(int value);
   inline void genCmulVar(int value1, int value2);
+  inline void genMultiCmulStart(int value);
+  inline void genMultiCmulTarget(int value1, int value2);
+  inline void genMultiCmulEnd(void);
   inline void genInfLoop(void);
+  inline void genPuts(const std::string &str, int value);
+  inline void genIf(void);
 public:
-  GeneratorCpp(BfIR irCode, std::size_t codeSize=DEFAULT_MAX_CODE_SIZE,
+  GeneratorCpp(const BfIRModule &irModule, std::size_t /* codeSize */=DEFAULT_MAX_CODE_SIZE,
       const char *indent="  ") :
-    SourceGenerator(irCode, indent, 1) {}
+    SourceGenerator(irModule, indent, 1) {}
 };
 
 
@@ -214,6 +221,36 @@ GeneratorCpp::genGetchar(void)
 }
 
 
+inline void
+GeneratorCpp::genPutcharAt(int value)
+{
+  if (value > 0) {
+    genMemoryCheck(value);
+    genIndent();
+    std::cout << "std::cout.put(memory[idx + " << value;
+  } else {
+    genIndent();
+    std::cout << "std::cout.put(memory[idx - " << -value;
+  }
+  std::cout << "]);\n";
+}
+
+
+inline void
+GeneratorCpp::genGetcharAt(int value)
+{
+  if (value > 0) {
+    genMemoryCheck(value);
+    genIndent();
+    std::cout << "memory[idx + " << value;
+  } else {
+    genIndent();
+    std::cout << "memory[idx - " << -value;
+  }
+  std::cout << "] = static_cast<unsigned char>(std::cin.get());\n";
+}
+
+
 inline void
 GeneratorCpp::genLoopStart(void)
 {
@@ -348,6 +385,41 @@ GeneratorCpp::genCmulVar(int value1, int value2)
 }
 
 
+inline void
+GeneratorCpp::genMultiCmulStart(int)
+{
+  genIndent();
+  std::cout << "if (memory[idx]) {\n";
+  indentLevel++;
+}
+
+
+inline void
+GeneratorCpp::genMultiCmulTarget(int value1, int value2)
+{
+  if (value1 >= 0) {
+    genMemoryCheck(value1);
+    genIndent();
+    std::cout << "memory[idx + " <<  value1;
+  } else {
+    genIndent();
+    std::cout << "memory[idx - " << -value1;
+  }
+  std::cout << "] += memory[idx] * " << value2 << ";\n";
+}
+
+
+inline void
+GeneratorCpp::genMultiCmulEnd(void)
+{
+  genIndent();
+  std::cout << "memory[idx] = 0;\n";
+  indentLevel--;
+  genIndent();
+  std::cout << "}\n";
+}
+
+
 inline void
 GeneratorCpp::genInfLoop(void)
 {
@@ -376,5 +448,24 @@ GeneratorCpp::genMemoryCheck(int value)
 }
 
 
+inline void
+GeneratorCpp::genPuts(const std::string &str, int)
+{
+  genIndent();
+  std::cout << "std::cout.write(";
+  genStringLiteral(str, OCTAL_ESCAPE);
+  std::cout << ", " << str.size() << ");\n";
+}
+
+
+inline void
+GeneratorCpp::genIf(void)
+{
+  genIndent();
+  std::cout << "if (memory[idx]) {\n";
+  indentLevel++;
+}
+
+
 }  // namespace bf
 #endif  // GENERATOR_CPP_H
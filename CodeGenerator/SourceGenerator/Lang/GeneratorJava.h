@@ -26,6 +26,8 @@ protected:
   inline void genSubAt(int value1, int value2);
   inline void genPutchar(void);
   inline void genGetchar(void);
+  inline void genPutcharAt(int value);
+  inline void genGetcharAt(int value);
   inline void genLoopStart(void);
   inline void genLoopEnd(void);
   inline void genAssign(int value);
@@ -34,11 +36,16 @@ protected:
   inline void genAddVar(int value);
   inline void genSubVar(int value);
   inline void genCmulVar(int value1, int value2);
+  inline void genMultiCmulStart(int value);
+  inline void genMultiCmulTarget(int value1, int value2);
+  inline void genMultiCmulEnd(void);
   inline void genInfLoop(void);
+  inline void genPuts(const std::string &str, int value);
+  inline void genIf(void);
 public:
-  GeneratorJava(BfIR irCode, std::size_t codeSize=DEFAULT_MAX_CODE_SIZE,
+  GeneratorJava(const BfIRModule &irModule, std::size_t /* codeSize */=DEFAULT_MAX_CODE_SIZE,
       const char *indent="    ") :
-    SourceGenerator(irCode, indent, 2) {}
+    SourceGenerator(irModule, indent, 2) {}
 };
 
 
@@ -196,6 +203,32 @@ GeneratorJava::genGetchar(void)
 }
 
 
+inline void
+GeneratorJava::genPutcharAt(int value)
+{
+  genIndent();
+  if (value > 0) {
+    std::cout << "System.out.print(memory[idx + " << value;
+  } else {
+    std::cout << "System.out.print(memory[idx - " << -value;
+  }
+  std::cout << "]);\n";
+}
+
+
+inline void
+GeneratorJava::genGetcharAt(int value)
+{
+  genIndent();
+  if (value > 0) {
+    std::cout << "memory[idx + " << value;
+  } else {
+    std::cout << "memory[idx - " << -value;
+  }
+  std::cout << "] = System.in.read();\n";
+}
+
+
 inline void
 GeneratorJava::genLoopStart(void)
 {
@@ -307,6 +340,39 @@ GeneratorJava::genCmulVar(int value1, int value2)
 }
 
 
+inline void
+GeneratorJava::genMultiCmulStart(int)
+{
+  genIndent();
+  std::cout << "if (memory[idx] != 0) {\n";
+  indentLevel++;
+}
+
+
+inline void
+GeneratorJava::genMultiCmulTarget(int value1, int value2)
+{
+  genIndent();
+  if (value1 >= 0) {
+    std::cout << "memory[idx + " <<  value1;
+  } else {
+    std::cout << "memory[idx - " << -value1;
+  }
+  std::cout << "] += memory[idx] * " << value2 << ";\n";
+}
+
+
+inline void
+GeneratorJava::genMultiCmulEnd(void)
+{
+  genIndent();
+  std::cout << "memory[idx] = 0;\n";
+  indentLevel--;
+  genIndent();
+  std::cout << "}\n";
+}
+
+
 inline void
 GeneratorJava::genInfLoop(void)
 {
@@ -319,5 +385,24 @@ GeneratorJava::genInfLoop(void)
 }
 
 
+inline void
+GeneratorJava::genPuts(const std::string &str, int)
+{
+  genIndent();
+  std::cout << "System.out.print(";
+  genStringLiteral(str, OCTAL_ESCAPE);
+  std::cout << ");\n";
+}
+
+
+inline void
+GeneratorJava::genIf(void)
+{
+  genIndent();
+  std::cout << "if (memory[idx] != 0) {\n";
+  indentLevel++;
+}
+
+
 }  // namespace bf
 #endif  // GENERATOR_JAVA_H
@@ -30,11 +30,16 @@ protected:
   inline void genAddVar(int value);
   inline void genSubVar(int value);
   inline void genCmulVar(int value1, int value2);
+  inline void genMultiCmulStart(int value);
+  inline void genMultiCmulTarget(int value1, int value2);
+  inline void genMultiCmulEnd(void);
   inline void genInfLoop(void);
+  inline void genPuts(const std::string &str, int value);
+  inline void genIf(void);
 public:
-  GeneratorLua(BfIR irCode, std::size_t codeSize=DEFAULT_MAX_CODE_SIZE,
+  GeneratorLua(const BfIRModule &irModule, std::size_t /* codeSize */=DEFAULT_MAX_CODE_SIZE,
       const char *indent="  ") :
-    SourceGenerator(irCode, indent, 0) {}
+    SourceGenerator(irModule, indent, 0) {}
 };
 
 
@@ -311,6 +316,42 @@ GeneratorLua::genCmulVar(int value1, int value2)
 }
 
 
+inline void
+GeneratorLua::genMultiCmulStart(int)
+{
+  genIndent();
+  std::cout << "if memory[idx] ~= 0 then\n";
+  indentLevel++;
+}
+
+
+inline void
+GeneratorLua::genMultiCmulTarget(int value1, int value2)
+{
+  genNilCheck(value1);
+  genIndent();
+  if (value1 >= 0) {
+    std::cout << "memory[idx + " << value1
+              << "] = memory[idx + " << value1;
+  } else {
+    std::cout << "memory[idx - " << -value1
+              << "] = memory[idx - " << -value1;
+  }
+  std::cout << "] + memory[idx] * " << value2 << "\n";
+}
+
+
+inline void
+GeneratorLua::genMultiCmulEnd(void)
+{
+  genIndent();
+  std::cout << "memory[idx] = 0\n";
+  indentLevel--;
+  genIndent();
+  std::cout << "end\n";
+}
+
+
 inline void
 GeneratorLua::genInfLoop(void)
 {
@@ -347,5 +388,24 @@ GeneratorLua::genNilCheck(int value)
 }
 
 
+inline void
+GeneratorLua::genPuts(const std::string &str, int)
+{
+  genIndent();
+  std::cout << "io.write(";
+  genStringLiteral(str, DECIMAL_ESCAPE);
+  std::cout << ")\n";
+}
+
+
+inline void
+GeneratorLua::genIf(void)
+{
+  genIndent();
+  std::cout << "if memory[idx] ~= 0 then\n";
+  indentLevel++;
+}
+
+
 }  // namespace bf
 #endif  // GENERATOR_LUA_H
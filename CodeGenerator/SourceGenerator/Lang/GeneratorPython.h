@@ -23,10 +23,12 @@ protected:
   inline void genAssign(int value);
   inline void genAddVar(int value);
   inline void genSubVar(int value);
+  inline void genPuts(const std::string &str, int value);
+  inline void genIf(void);
 public:
-  GeneratorPython(BfIR irCode, std::size_t codeSize=DEFAULT_MAX_CODE_SIZE,
+  GeneratorPython(const BfIRModule &irModule, std::size_t /* codeSize */=DEFAULT_MAX_CODE_SIZE,
       const char *indent="    ") :
-    SourceGenerator(irCode, indent, 1) {}
+    SourceGenerator(irModule, indent, 1) {}
 };
 
 
@@ -163,5 +165,24 @@ GeneratorPython::genSubVar(int value)
 }
 
 
+inline void
+GeneratorPython::genPuts(const std::string &str, int)
+{
+  genIndent();
+  std::cout << "sys.stdout.write(";
+  genStringLiteral(str, OCTAL_ESCAPE);
+  std::cout << ")\n";
+}
+
+
+inline void
+GeneratorPython::genIf(void)
+{
+  genIndent();
+  std::cout << "if memory[idx] != 0:\n";
+  indentLevel++;
+}
+
+
 }  // namespace bf
 #endif  // GENERATOR_PYTHON_H
@@ -23,10 +23,12 @@ protected:
   inline void genAssign(int value);
   inline void genAddVar(int value);
   inline void genSubVar(int value);
+  inline void genPuts(const std::string &str, int value);
+  inline void genIf(void);
 public:
-  GeneratorRuby(BfIR irCode, std::size_t codeSize=DEFAULT_MAX_CODE_SIZE,
+  GeneratorRuby(const BfIRModule &irModule, std::size_t /* codeSize */=DEFAULT_MAX_CODE_SIZE,
       const char *indent="  ") :
-    SourceGenerator(irCode, indent, 1) {}
+    SourceGenerator(irModule, indent, 1) {}
 };
 
 
@@ -172,5 +174,24 @@ GeneratorRuby::genSubVar(int value)
 }
 
 
+inline void
+GeneratorRuby::genPuts(const std::string &str, int)
+{
+  genIndent();
+  std::cout << "print ";
+  genStringLiteral(str, OCTAL_ESCAPE);
+  std::cout << "\n";
+}
+
+
+inline void
+GeneratorRuby::genIf(void)
+{
+  genIndent();
+  std::cout << "unless memory[idx] == 0\n";
+  indentLevel++;
+}
+
+
 }  // namespace bf
 #endif  // GENERATOR_RUBY_H
@@ -6,6 +6,8 @@
 #ifndef SOURCE_GENERATOR_H
 #define SOURCE_GENERATOR_H
 
+#include <cstring>
+#include <string>
 #include "../CodeGenerator.h"
 
 
@@ -19,13 +21,23 @@ class SourceGenerator : public CodeGenerator {
 private:
   static const int DEFAULT_INDENT_LEVEL = 1;
 protected:
+  /*!
+   * @brief Escape sequence for the bytes which are not printed as they are
+   */
+  typedef enum {
+    OCTAL_ESCAPE,    //!< \ooo
+    DECIMAL_ESCAPE,  //!< \ddd
+    UNICODE_ESCAPE   //!< \u00hh
+  } EscapeStyle;
+
   static const std::size_t DEFAULT_MAX_CODE_SIZE = 1048576;
   int indentLevel;
   const char *indent;
   inline void genIndent(void);
+  inline void genStringLiteral(const std::string &str, EscapeStyle style);
 public:
-  SourceGenerator(BfIR irCode, const char *indent="  ", int indentLevel=DEFAULT_INDENT_LEVEL) :
-    CodeGenerator(irCode), indentLevel(indentLevel), indent(indent) {}
+  SourceGenerator(const BfIRModule &irModule, const char *indent="  ", int indentLevel=DEFAULT_INDENT_LEVEL) :
+    CodeGenerator(irModule), indentLevel(indentLevel), indent(indent) {}
   inline void genCode(void);
 };
 
@@ -54,5 +66,47 @@ SourceGenerator::genIndent(void)
 }
 
 
+/*!
+ * @brief Generate double-quoted string literal
+ *
+ * Only the alphanumeric characters, the space and the punctuations which
+ * have no special meaning in any language are printed as they are.
+ * @param [in] str    Content of the literal
+ * @param [in] style  Escape sequence for the other bytes
+ */
+inline void
+SourceGenerator::genStringLiteral(const std::string &str, EscapeStyle style)
+{
+  static const char HEX_DIGITS[] = "0123456789abcdef";
+  std::cout << '"';
+  for (std::string::const_iterator itr = str.begin(), end = str.end(); itr != end; itr++) {
+    int ch = static_cast<unsigned char>(*itr);
+    if ((ch >= 'A' && ch <= 'Z') || (ch >= 'a' && ch <= 'z') || (ch >= '0' && ch <= '9')
+        || (ch != '\0' && std::strchr(" !%&'()*+,-./:;<=>@[]^_`{|}~", ch) != nullptr)) {
+      std::cout << static_cast<char>(ch);
+      continue;
+    }
+    switch (style) {
+      case OCTAL_ESCAPE:
+        std::cout << '\\'
+                  << static_cast<char>('0' + (ch >> 6))
+                  << static_cast<char>('0' + ((ch >> 3) & 7))
+                  << static_cast<char>('0' + (ch & 7));
+        break;
+      case DECIMAL_ESCAPE:
+        std::cout << '\\'
+                  << static_cast<char>('0' + ch / 100)
+                  << static_cast<char>('0' + ch / 10 % 10)
+                  << static_cast<char>('0' + ch % 10);
+        break;
+      case UNICODE_ESCAPE:
+        std::cout << "\\u00" << HEX_DIGITS[ch >> 4] << HEX_DIGITS[ch & 0xf];
+        break;
+    }
+  }
+  std::cout << '"';
+}
+
+
 }  // namespace bf
 #endif  // SOURCE_GENERATOR_H
@@ -20,7 +20,9 @@ public:
   OptionParser(int argc, char *argv[]) :
     argc(argc),
     optLevel(1),
+    cellBits(DEFAULT_CELL_BITS),
     memorySize(DEFAULT_MEMORY_SIZE),
+    safe(false),
     status(STATUS_OK),
     argv(argv),
     programName(argv[0]),
@@ -29,16 +31,21 @@ public:
   void parse(void);
   void help(void) const;
   int getOptLevel(void) const { return optLevel; }
+  int getCellBits(void) const { return cellBits; }
   std::size_t getMemorySize(void) const { return memorySize; }
+  bool isSafe(void) const { return safe; }
   Status getStatus(void) const { return status; }
   const char *getInFilename(void) const { return inFilename; }
   const char *getTarget(void) const { return target; }
 
 private:
   static const std::size_t DEFAULT_MEMORY_SIZE = 65536;
+  static const int DEFAULT_CELL_BITS = 8;
   int argc;
   int optLevel;
+  int cellBits;
   std::size_t memorySize;
+  bool safe;
   Status status;
   char** argv;
   const char* programName;
@@ -75,26 +82,24 @@ main(int argc, char* argv[])
     if (status == OptionParser::STATUS_EXIT) return EXIT_SUCCESS;
     if (status == OptionParser::STATUS_ERROR) return EXIT_FAILURE;
 
-    bf::Brainfuck bf(op.getMemorySize());
+    bf::Brainfuck bf(op.getMemorySize(), op.getCellBits() / 8);
+    bf.setSafeMode(op.isSafe());
     bf.load(op.getInFilename());
-    bf.trim();
-
-    int optLevel = op.getOptLevel();
-#ifdef USE_XBYAK
-    if (optLevel >= 2) {
-      bf.compile(bf::Brainfuck::XBYAK_JIT_COMPILE);
-    } else if (optLevel == 1) {
-      bf.compile(bf::Brainfuck::NORMAL_COMPILE);
-    }
-#else
-    if (optLevel >= 1) {
-      bf.compile(bf::Brainfuck::NORMAL_COMPILE);
-    }
-#endif  // USE_XBYAK
 
     char *target = const_cast<char *>(op.getTarget());
     bf::Brainfuck::LANG lang;
     if (target == nullptr) {
+      // Translators compile the source by themselves
+      int optLevel = op.getOptLevel();
+      if (optLevel >= 3) {
+        bf.compile(bf::Brainfuck::THREADED_COMPILE);
+#ifdef USE_XBYAK
+      } else if (optLevel == 2) {
+        bf.compile(bf::Brainfuck::XBYAK_JIT_COMPILE);
+#endif  // USE_XBYAK
+      } else if (optLevel >= 1) {
+        bf.compile(bf::Brainfuck::NORMAL_COMPILE);
+      }
       bf.execute();
     } else if (convertTarget(&lang, target)) {
       bf.translate(lang);
@@ -130,17 +135,30 @@ void
 OptionParser::parse(void)
 {
   static const struct option opts[] = {
+    {"cell-bits", required_argument, nullptr, 'b'},
     {"compile",  required_argument, nullptr, 'c'},
     {"help",     no_argument,       nullptr, 'h'},
     {"optimize", required_argument, nullptr, 'O'},
+    {"safe",     no_argument,       nullptr, 'S'},
     {"size",     required_argument, nullptr, 's'},
     {nullptr, 0, nullptr, '\0'}  // must be filled with zero
   };
   int ret;
   int optidx = 0;
   std::stringstream ss;
-  while ((ret = getopt_long(argc, argv, "c:ho:O:s:", opts, &optidx)) != EOF) {
+  while ((ret = getopt_long(argc, argv, "b:c:ho:O:Ss:", opts, &optidx)) != EOF) {
     switch (ret) {
+      case 'b':  // -b, --cell-bits
+        ss << optarg;
+        ss >> cellBits;
+        ss.clear();
+        ss.str("");
+        if (cellBits != 8 && cellBits != 16 && cellBits != 32) {
+          std::cerr << "Invalid cell width: " << optarg << std::endl;
+          status = STATUS_ERROR;
+          return;
+        }
+        break;
       case 'c':  // -c, --compile
         target = optarg;
         break;
@@ -154,6 +172,9 @@ OptionParser::parse(void)
         ss.clear();
         ss.str("");
         break;
+      case 'S':  // -S, --safe
+        safe = true;
+        break;
       case 's':  // -s, --size
         ss << optarg;
         ss >> memorySize;
@@ -166,6 +187,11 @@ OptionParser::parse(void)
         return;
     }
   }
+  if (safe && target == nullptr && (optLevel <= 0 || optLevel >= 3)) {
+    std::cerr << "Safe mode is not available with OPT_LEVEL = " << optLevel << std::endl;
+    status = STATUS_ERROR;
+    return;
+  }
   if (optind != argc - 1) {
     std::cerr << "Please specify one brainfuck source code" << std::endl;
     help();
@@ -185,6 +211,13 @@ OptionParser::help(void) const
   std::cout << "[Usage]\n"
             << "  $ " << programName << " FILE [options]\n\n"
                "[Options]\n"
+               "  -b CELL_BITS, --cell-bits=CELL_BITS\n"
+#ifdef USE_XBYAK
+               "    Specify the width of the cell of simple compile and JIT compile: 8, 16 or 32\n"
+#else
+               "    Specify the width of the cell of simple compile: 8, 16 or 32\n"
+#endif  // USE_XBYAK
+               "    Default value: CELL_BITS = " << DEFAULT_CELL_BITS << "\n"
                "  -c TARGET, --compile=TARGET\n"
                "    Specify output type\n"
                "      - c:      Compile to C source code\n"
@@ -208,9 +241,16 @@ OptionParser::help(void) const
 #ifdef USE_XBYAK
                "      - 2: Execute with JIT compile\n"
 #endif  // USE_XBYAK
+               "      - 3: Execute with direct-threaded code\n"
                "    Default value: OPT_LEVEL = 1\n"
+               "  -S, --safe\n"
+               "    Check the bounds of the memory, which doesn't grow, and stop with an error\n"
+               "    on overflow\n"
+               "    Available with OPT_LEVEL = 1 and OPT_LEVEL = 2, whose checks are hoisted out of\n"
+               "    the loops\n"
                "  -s MEMORY_SIZE, --size=MEMORY_SIZE\n"
                "    Specify memory size\n"
+               "    On execution, this is the initial size and the memory grows on demand\n"
                "    Default value: MEMORY_SIZE = " << DEFAULT_MEMORY_SIZE << "\n"
             << std::endl;
 }
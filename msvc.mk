@@ -50,13 +50,35 @@ MAIN_OBJ = main.obj
 OBJ1     = brainfuck.obj
 OBJ2     = BfIRCompiler.obj
 OBJ3     = BfJitCompiler.obj
+OBJ4     = BfThreadedCompiler.obj
+OBJ5     = BfBytecode.obj
+OBJ6     = BfIROptimizer.obj
+OBJ7     = BfSimd.obj
+OBJ8     = BfIO.obj
+OBJ9     = BfSourceFile.obj
+OBJ10    = BfTape.obj
 MAIN_SRC = $(MAIN_OBJ:.obj=.cpp)
 SRC1     = $(OBJ1:.obj=.cpp)
 SRC2     = $(OBJ2:.obj=.cpp)
 SRC3     = $(OBJ3:.obj=.cpp)
+SRC4     = $(OBJ4:.obj=.cpp)
+SRC5     = $(OBJ5:.obj=.cpp)
+SRC6     = $(OBJ6:.obj=.cpp)
+SRC7     = $(OBJ7:.obj=.cpp)
+SRC8     = $(OBJ8:.obj=.cpp)
+SRC9     = $(OBJ9:.obj=.cpp)
+SRC10    = $(OBJ10:.obj=.cpp)
 HEADER1  = $(OBJ1:.obj=.h)
 HEADER2  = $(OBJ2:.obj=.h)
 HEADER3  = $(OBJ3:.obj=.h)
+HEADER4  = $(OBJ4:.obj=.h)
+HEADER5  = $(OBJ5:.obj=.h)
+HEADER6  = $(OBJ6:.obj=.h)
+HEADER7  = $(OBJ7:.obj=.h)
+HEADER8  = $(OBJ8:.obj=.h)
+HEADER9  = $(OBJ9:.obj=.h)
+HEADER10 = $(OBJ10:.obj=.h)
+POLICIES = BfPolicy.h
 
 GENERATOR_DIR      = CodeGenerator
 SRC_GENERATOR_DIR  = $(GENERATOR_DIR)/SourceGenerator
@@ -89,7 +111,7 @@ GENERATORS = $(GENERATOR_DIR)/CodeGenerator.h \
 
 all: $(GETOPT_LIBS_DIR)/$(GETOPT_LIB) $(XBYAK_DIR)/xbyak/xbyak.h $(MSVCDBG_DIR)/NUL $(TARGET)
 
-$(TARGET): $(MAIN_OBJ) $(OBJ1) $(OBJ2) $(OBJ3)
+$(TARGET): $(MAIN_OBJ) $(OBJ1) $(OBJ2) $(OBJ3) $(OBJ4) $(OBJ5) $(OBJ6) $(OBJ7) $(OBJ8) $(OBJ9) $(OBJ10)
 
 $(MAIN_OBJ): $(MAIN_SRC)
 
@@ -97,11 +119,25 @@ $(MAIN_SRC): $(HEADER1)
 
 $(OBJ1): $(SRC1)
 
-$(SRC1): $(HEADER1) $(HEADER2) $(HEADER3) $(GENERATORS)
+$(SRC1): $(HEADER1) $(HEADER2) $(HEADER3) $(HEADER4) $(HEADER5) $(HEADER7) $(HEADER8) $(HEADER9) $(HEADER10) $(POLICIES) $(GENERATORS)
 
-$(SRC2): $(HEADER2)
+$(SRC2): $(HEADER2) $(HEADER6) $(HEADER7)
 
-$(SRC3): $(HEADER3)
+$(SRC3): $(HEADER3) $(HEADER7)
+
+$(SRC4): $(HEADER4) $(HEADER7) $(HEADER8)
+
+$(SRC5): $(HEADER5) $(HEADER2)
+
+$(SRC6): $(HEADER6) $(HEADER2)
+
+$(SRC7): $(HEADER7)
+
+$(SRC8): $(HEADER8)
+
+$(SRC9): $(HEADER9)
+
+$(SRC10): $(HEADER10)
 
 
 $(XBYAK_DIR)/xbyak/xbyak.h:
@@ -123,6 +159,6 @@ test:
 
 
 clean:
-	$(RM) $(TARGET) $(MAIN_OBJ) $(OBJ1) $(OBJ2) $(OBJ3) *.ilk *.pdb
+	$(RM) $(TARGET) $(MAIN_OBJ) $(OBJ1) $(OBJ2) $(OBJ3) $(OBJ4) $(OBJ5) $(OBJ6) $(OBJ7) $(OBJ8) $(OBJ9) $(OBJ10) *.ilk *.pdb
 cleanobj:
-	$(RM) $(MAIN_OBJ) $(OBJ1) $(OBJ2) $(OBJ3) *.ilk *.pdb
+	$(RM) $(MAIN_OBJ) $(OBJ1) $(OBJ2) $(OBJ3) $(OBJ4) $(OBJ5) $(OBJ6) $(OBJ7) $(OBJ8) $(OBJ9) $(OBJ10) *.ilk *.pdb
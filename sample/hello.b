@@ -0,0 +1,17 @@
+Print Hello World
+
+++++++++++[>+++++++>++++++++++>+++>+<<<<-]
+>++.
+>+.
++++++++.
+.
++++.
+>++++++++++++++.
+------------.
+<<+++++++++++++++.
+>.
++++.
+------.
+--------.
+>+.
+>.
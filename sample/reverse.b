@@ -0,0 +1,5 @@
+Read three bytes and print them in reverse order with each byte incremented
+
+,>,>,
++.<+.<+.
+>>>++++++++++.
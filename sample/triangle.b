@@ -0,0 +1,14 @@
+Print a triangle of asterisks
+The number of the rows is the first byte of the input minus seventy one
+
+,>++++++++[<--------->-]<+  rows
+>++++++[>+++++++<-]         asterisk
+>>++++++++++                newline
+<<<
+[
+  >>>>+                     width
+  [>+>+<<-]>>[<<+>>-]       copy the width
+  <[<<<.>>>-]               print the row
+  <<.
+  <<<-
+]
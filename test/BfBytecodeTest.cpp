@@ -0,0 +1,176 @@
+/*!
+ * @file BfBytecodeTest.cpp
+ * @brief Check that the bytecode is decoded into the original Brainfuck-IR
+ * @author koturn
+ */
+#include <climits>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include "../BfBytecode.h"
+#include "../BfIRCompiler.h"
+
+
+static bool
+checkRoundTrip(const char *name, const bf::BfIR &irCode);
+
+static bf::BfIR
+makeAllInstructions(void);
+
+static void
+append(bf::BfIR &irCode, bf::BfInstruction::Instruction type, int value1=0, int value2=0);
+
+
+
+
+/*!
+ * @brief Entry point of this program
+ *
+ * Each Brainfuck source file given as an argument is compiled with and
+ * without the bounds check, and its IR is checked as well as the IR which
+ * contains every instruction.
+ * @param [in] argc  The number of command-line arguments
+ * @param [in] argv  Command-line arguments
+ * @return Exit-status
+ */
+int
+main(int argc, char *argv[])
+{
+  bool isOk = checkRoundTrip("every instruction", makeAllInstructions());
+  for (int i = 1; i < argc; i++) {
+    std::ifstream ifs(argv[i]);
+    if (!ifs.is_open()) {
+      std::cerr << "Cannot open file: " << argv[i] << std::endl;
+      return EXIT_FAILURE;
+    }
+    std::string source((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    for (int isChecked = 0; isChecked < 2; isChecked++) {
+      bf::BfIRCompiler irCompiler(source.c_str());
+      irCompiler.setBoundsCheck(isChecked != 0);
+      irCompiler.setOffsetLimit(true);
+      irCompiler.setPrefixEvaluation(true);
+      try {
+        irCompiler.compile();
+      } catch (const std::exception &) {
+        // The error paths are checked by test/run.sh
+        continue;
+      }
+      isOk &= checkRoundTrip(argv[i], irCompiler.getCode());
+    }
+  }
+  return isOk ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+/*!
+ * @brief Encode IR code, decode it and compare the result with the original
+ * @param [in] name    Name of the code which is shown on the failure
+ * @param [in] irCode  Brainfuck IR code
+ * @return True if the decoded code is equal to the original, otherwise false
+ */
+static bool
+checkRoundTrip(const char *name, const bf::BfIR &irCode)
+{
+  bf::BfBytecode bytecode;
+  bytecode.encode(irCode);
+  bf::BfIR decoded = bytecode.decode();
+  if (decoded.size() != irCode.size()) {
+    std::cerr << name << ": " << decoded.size() << " instructions are decoded from "
+              << irCode.size() << " instructions" << std::endl;
+    return false;
+  }
+  for (bf::BfIR::size_type i = 0; i < irCode.size(); i++) {
+    if (decoded[i].type != irCode[i].type
+        || decoded[i].value1 != irCode[i].value1
+        || decoded[i].value2 != irCode[i].value2) {
+      std::cerr << name << ": instruction " << i << " ("
+                << irCode[i].type << ", " << irCode[i].value1 << ", " << irCode[i].value2
+                << ") is decoded into ("
+                << decoded[i].type << ", " << decoded[i].value1 << ", " << decoded[i].value2
+                << ")" << std::endl;
+      return false;
+    }
+  }
+  std::cout << name << ": ok (" << irCode.size() << " instructions in "
+            << bytecode.getSize() << " bytes)" << std::endl;
+  return true;
+}
+
+
+/*!
+ * @brief Make IR code which contains every instruction
+ *
+ * The operands include the negative values and the boundary values of the
+ * zigzag-encoded varint, and IF blocks are nested in the loops.
+ * @return Brainfuck IR code
+ */
+static bf::BfIR
+makeAllInstructions(void)
+{
+  static const int VALUES[] = {0, 1, -1, 63, -64, 64, -65, 8191, -8192, 8192, INT_MAX, INT_MIN};
+  bf::BfIR irCode;
+  for (std::size_t i = 0; i < sizeof(VALUES) / sizeof(VALUES[0]); i++) {
+    int v = VALUES[i];
+    int w = VALUES[sizeof(VALUES) / sizeof(VALUES[0]) - 1 - i];
+    bf::BfIR::size_type loopPos = irCode.size();
+    append(irCode, bf::BfInstruction::LOOP_START);
+    append(irCode, bf::BfInstruction::NEXT);
+    append(irCode, bf::BfInstruction::PREV);
+    append(irCode, bf::BfInstruction::NEXT_N, v);
+    append(irCode, bf::BfInstruction::PREV_N, v);
+    append(irCode, bf::BfInstruction::INC);
+    append(irCode, bf::BfInstruction::DEC);
+    append(irCode, bf::BfInstruction::ADD, v);
+    append(irCode, bf::BfInstruction::SUB, v);
+    append(irCode, bf::BfInstruction::INC_AT, v);
+    append(irCode, bf::BfInstruction::DEC_AT, v);
+    append(irCode, bf::BfInstruction::ADD_AT, v, w);
+    append(irCode, bf::BfInstruction::SUB_AT, v, w);
+    append(irCode, bf::BfInstruction::PUTCHAR, v);
+    append(irCode, bf::BfInstruction::GETCHAR, v);
+    bf::BfIR::size_type ifPos = irCode.size();
+    append(irCode, bf::BfInstruction::IF);
+    append(irCode, bf::BfInstruction::ASSIGN_ZERO);
+    append(irCode, bf::BfInstruction::ASSIGN, v);
+    append(irCode, bf::BfInstruction::ASSIGN_AT, v, w);
+    append(irCode, bf::BfInstruction::SEARCH_ZERO, v);
+    bf::BfIR::size_type innerIfPos = irCode.size();
+    append(irCode, bf::BfInstruction::IF);
+    append(irCode, bf::BfInstruction::ADD_VAR, v);
+    append(irCode, bf::BfInstruction::SUB_VAR, v);
+    append(irCode, bf::BfInstruction::CMUL_VAR, v, w);
+    append(irCode, bf::BfInstruction::MULTI_CMUL_VAR, 2);
+    append(irCode, bf::BfInstruction::CMUL_TARGET, v, w);
+    append(irCode, bf::BfInstruction::CMUL_TARGET, w, v);
+    append(irCode, bf::BfInstruction::END_IF, static_cast<int>(innerIfPos));
+    irCode[innerIfPos].value1 = static_cast<int>(irCode.size() - 1);
+    append(irCode, bf::BfInstruction::END_IF, static_cast<int>(ifPos));
+    irCode[ifPos].value1 = static_cast<int>(irCode.size() - 1);
+    append(irCode, bf::BfInstruction::CHECK, v, w);
+    append(irCode, bf::BfInstruction::PUTS, static_cast<int>(i), v);
+    append(irCode, bf::BfInstruction::LOOP_END, static_cast<int>(loopPos));
+    irCode[loopPos].value1 = static_cast<int>(irCode.size() - 1);
+  }
+  append(irCode, bf::BfInstruction::INF_LOOP);
+  return irCode;
+}
+
+
+/*!
+ * @brief Append an instruction to IR code
+ * @param [in,out] irCode  Brainfuck IR code
+ * @param [in]     type    Type of the instruction
+ * @param [in]     value1  The first operand
+ * @param [in]     value2  The second operand
+ */
+static void
+append(bf::BfIR &irCode, bf::BfInstruction::Instruction type, int value1, int value2)
+{
+  bf::BfInstruction::Command cmd;
+  cmd.type = type;
+  cmd.value1 = value1;
+  cmd.value2 = value2;
+  irCode.push_back(cmd);
+}
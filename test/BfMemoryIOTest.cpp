@@ -0,0 +1,153 @@
+/*!
+ * @file BfMemoryIOTest.cpp
+ * @brief Run the test programs with each engine on BfMemoryIO
+ * @author koturn
+ */
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include "../Brainfuck.h"
+
+
+/*!
+ * @brief Engine and its options
+ */
+struct Engine {
+  //! Name which is shown on the failure
+  const char *name;
+  //! How the source code is compiled
+  bf::Brainfuck::CompileType compileType;
+  //! Width of the cell in bytes
+  int cellSize;
+  //! Whether the code is compiled with bounds checks
+  bool safeMode;
+};
+
+
+//! Error on the tape overflow, which ends the process unless it is checked
+static const char TAPE_OVERFLOW[] = "Tape overflow: the pointer is out of the tape\n";
+
+
+static bool
+checkEngine(const char *filename, const Engine &engine, const std::string &input,
+            const std::string &expectedOutput, const std::string &expectedError);
+
+static bool
+readFile(const std::string &filename, std::string &content);
+
+
+
+
+/*!
+ * @brief Entry point of this program
+ *
+ * Each Brainfuck source file given as an argument is run like test/run.sh,
+ * but the input and the output go through BfMemoryIO.
+ * The tape overflow is expected only of the engines with bounds checks.
+ * @param [in] argc  The number of command-line arguments
+ * @param [in] argv  Command-line arguments
+ * @return Exit-status
+ */
+int
+main(int argc, char *argv[])
+{
+  static const Engine ENGINES[] = {
+    {"NO_COMPILE", bf::Brainfuck::NO_COMPILE, 1, false},
+    {"NORMAL_COMPILE", bf::Brainfuck::NORMAL_COMPILE, 1, false},
+    {"NORMAL_COMPILE -b16", bf::Brainfuck::NORMAL_COMPILE, 2, false},
+    {"NORMAL_COMPILE -b32", bf::Brainfuck::NORMAL_COMPILE, 4, false},
+    {"NORMAL_COMPILE -S", bf::Brainfuck::NORMAL_COMPILE, 1, true},
+#ifdef USE_XBYAK
+    {"XBYAK_JIT_COMPILE", bf::Brainfuck::XBYAK_JIT_COMPILE, 1, false},
+    {"XBYAK_JIT_COMPILE -b16", bf::Brainfuck::XBYAK_JIT_COMPILE, 2, false},
+    {"XBYAK_JIT_COMPILE -b32", bf::Brainfuck::XBYAK_JIT_COMPILE, 4, false},
+    {"XBYAK_JIT_COMPILE -S", bf::Brainfuck::XBYAK_JIT_COMPILE, 1, true},
+#endif  // USE_XBYAK
+    {"THREADED_COMPILE", bf::Brainfuck::THREADED_COMPILE, 1, false}
+  };
+  bool isOk = true;
+  for (int i = 1; i < argc; i++) {
+    std::string base(argv[i]);
+    base.erase(base.rfind('.'));
+    std::string input, expectedOutput, expectedError;
+    readFile(base + ".in", input);
+    if (!readFile(base + ".out", expectedOutput)) {
+      std::cerr << "Cannot open file: " << base << ".out" << std::endl;
+      return EXIT_FAILURE;
+    }
+    readFile(base + ".err", expectedError);
+    bool isPassed = true;
+    for (std::size_t j = 0; j < sizeof(ENGINES) / sizeof(ENGINES[0]); j++) {
+      // The unchecked engines report the overflow from the fault handler
+      if (expectedError == TAPE_OVERFLOW && !ENGINES[j].safeMode) {
+        continue;
+      }
+      isPassed &= checkEngine(argv[i], ENGINES[j], input, expectedOutput, expectedError);
+    }
+    if (isPassed) {
+      std::cout << argv[i] << ": ok" << std::endl;
+    }
+    isOk &= isPassed;
+  }
+  return isOk ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+/*!
+ * @brief Run a Brainfuck source file with the engine and check its output
+ * @param [in] filename        Brainfuck source file
+ * @param [in] engine          Engine and its options
+ * @param [in] input           Input of the program
+ * @param [in] expectedOutput  Expected output
+ * @param [in] expectedError   Expected error message followed by a newline,
+ *                             or an empty string if no error is expected
+ * @return True if the output and the error are expected, otherwise false
+ */
+static bool
+checkEngine(const char *filename, const Engine &engine, const std::string &input,
+            const std::string &expectedOutput, const std::string &expectedError)
+{
+  bf::BfMemoryIO io(input);
+  std::string error;
+  try {
+    bf::Brainfuck bf(65536, engine.cellSize);
+    bf.setIO(io);
+    bf.setSafeMode(engine.safeMode);
+    bf.load(filename);
+    bf.compile(engine.compileType);
+    bf.execute();
+  } catch (const std::exception &e) {
+    error = std::string(e.what()) + "\n";
+  }
+  if (io.getOutput() != expectedOutput) {
+    std::cerr << filename << ": output of " << engine.name << " differs" << std::endl;
+    return false;
+  }
+  if (error != expectedError) {
+    std::cerr << filename << ": " << engine.name << " fails with \"" << error
+              << "\" instead of \"" << expectedError << "\"" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+
+/*!
+ * @brief Read the whole content of a file
+ * @param [in]  filename  File to read
+ * @param [out] content   Content of the file
+ * @return True if the file is read, otherwise false
+ */
+static bool
+readFile(const std::string &filename, std::string &content)
+{
+  std::ifstream ifs(filename.c_str(), std::ios::in | std::ios::binary);
+  if (!ifs.is_open()) {
+    return false;
+  }
+  content.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+  return true;
+}
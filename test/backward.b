@@ -0,0 +1,2 @@
+Read a line and print it backward; the pointer runs back to the start of tape
+>,----------[++++++++++>,----------]<[.<]
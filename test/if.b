@@ -0,0 +1,9 @@
+Each body clears the flag which is read so that the loop runs at most once
+A flag which is set and a flag which is zero
+,[.[-]]>,[.[-]]
+A flag in the body of another flag
+>,[>,[.[-]]<[-]]
+Flags in the body of a loop which runs three times
+>+++[>,[.[-]]<-]
+A body which moves the pointer and clears the cell where it ends
+>>>++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++<<,[[-]>[-]]>.
@@ -0,0 +1,22 @@
+Known values of the cells
+
+Move the input into cell 1; cell 0 is zero after the loop so that the clear
+and the second loop are dead
+,[>+<-][-][.]
+Print A from a known zero through a negative value
+---++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++.
+Print A again through a value beyond 255
+>>++++++++++++++++++++[<<++++++++++++++++>>-]<<
+--------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------.
+Clear and decrement then increment back to zero; the loop must not run
+[-]-+[>>>.<<<[-]]
+Cell 2 is K and the loop on cell 1 writes only cell 3 and cell 4
+>>+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+<[>>+>+<<<-]>.>.
+Add the known counter to cell 3 which holds the input
+<<<++[>>>+<<<-]>>>.
+The loop on cell 5 prints K as many times as the second input and writes
+only cell 6 without moving the pointer
+>>,[<<<.>>>>+<-]>.
+The search moves the pointer so that every known value is forgotten
+<<[<]>>>.
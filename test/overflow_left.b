@@ -0,0 +1,3 @@
+Print the input byte 1500 times so that the output of the JIT outgrows its
+buffer and then step off the left end of the tape
+,>+++++++++++++++[>++++++++++[>++++++++++[<<<.>>>-]<-]<-]<<+
@@ -0,0 +1,8 @@
+Print the digits in a cheap loop which is evaluated at compile time
++++++++[>+++++++<-]>--<++++++++++[>+.<-]
+Count from a to z with heavy work in each step so that the evaluation at
+compile time runs out of its budget in the middle of the loop
+>>++++++++[>++++++++++++<-]
+++++++++++++++++++++++++++[>+.>>+++++++++++++++[>+++++++++++++++[>+++++++++++++++[>+++++++++++++++[-]<-]<-]<-]<<<-]
+Then echo the input at runtime
+,.
@@ -0,0 +1,7 @@
+Constant output around the input
+,>+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++.++++.<.>----.++++.
+A constant string longer than the output buffer of the JIT
+>++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++............................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................................
+The last values of the cells are printed in a loop which runs as many times
+as the input
+<<[>.>.<<-]
@@ -0,0 +1,3 @@
+Constant output must be written before an access to an unknown cell off the
+left end of the tape
+,>+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++.----.<<+
@@ -0,0 +1,45 @@
+#!/bin/sh
+# Run the test programs with each engine and compare them with the expectation.
+#
+#   sh test/run.sh BRAINFUCK TEST.b...
+#
+# TEST.in is given as the input (/dev/null if it doesn't exist).
+# TEST.out is the expected output.
+# TEST.err is the expected error message; the program must fail if it exists.
+
+ENGINES='-O0 -O1 -O1:-b16 -O1:-b32 -O1:-S -O2 -O2:-b16 -O2:-b32 -O2:-S -O3'
+
+if [ $# -lt 2 ]; then
+  echo "Usage: sh $0 BRAINFUCK TEST.b..." >&2
+  exit 1
+fi
+bf=$1
+shift
+
+tmpdir=`mktemp -d` || exit 1
+trap 'rm -rf "$tmpdir"' 0
+status=0
+for src in "$@"; do
+  base=${src%.b}
+  input=$base.in
+  [ -f "$input" ] || input=/dev/null
+  for engine in $ENGINES; do
+    flags=`echo "$engine" | tr : ' '`
+    $bf $flags "$src" < "$input" > "$tmpdir/out" 2> "$tmpdir/err"
+    rc=$?
+    if ! cmp -s "$tmpdir/out" "$base.out"; then
+      echo "$src: output of $flags differs from $base.out" >&2
+      status=1
+    elif [ -f "$base.err" ]; then
+      if [ $rc -eq 0 ] || ! cmp -s "$tmpdir/err" "$base.err"; then
+        echo "$src: $flags doesn't fail as $base.err" >&2
+        status=1
+      fi
+    elif [ $rc -ne 0 ]; then
+      echo "$src: $flags fails: `cat "$tmpdir/err"`" >&2
+      status=1
+    fi
+  done
+  echo "$src: done"
+done
+exit $status
@@ -0,0 +1,82 @@
+The outer loop is not closed until the end of the source
+[[]
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
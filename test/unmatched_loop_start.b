@@ -0,0 +1,83 @@
+The closing bracket is found after the first block of the source
++
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+This comment pushes the bracket out of the first block of the source
+]